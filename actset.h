@@ -0,0 +1,88 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+
+#ifndef ACTSET_HEADER_FILE_INCLUDED
+#define ACTSET_HEADER_FILE_INCLUDED
+
+/*
+  Index of the active elements among elements with dense IDs from 0 to
+  count() - 1 for sampling them at random
+  The IDs are kept in a permutation holding the active elements first,
+  which lets k random active elements be deactivated in O(k) time
+  The index only mirrors the activation state kept elsewhere, e.g. in
+  m_dactTime, and its owner rebuilds it when the two may differ
+*/
+class ActiveIndex
+{
+  // element IDs, the active ones in the first m_numAct positions
+  std::vector<int> m_order;
+  // positions of the elements in m_order
+  std::vector<int> m_pos;
+  int m_numAct;
+
+  bool m_valid;
+
+  inline void swapPositions(int p1, int p2)
+  {
+    const int id1 = m_order[p1], id2 = m_order[p2];
+    m_order[p1] = id2;
+    m_pos[id2] = p1;
+    m_order[p2] = id1;
+    m_pos[id1] = p2;
+  }
+
+public:
+  ActiveIndex() : m_numAct(0), m_valid(false)
+  {
+  }
+
+  // makes count elements, all of them active
+  void reset(int count)
+  {
+    m_order.resize(count);
+    m_pos.resize(count);
+    for (int i = 0; i < count; i++)
+      m_order[i] = m_pos[i] = i;
+    m_numAct = count;
+    m_valid = true;
+  }
+
+  // marks the index as not matching the elements it was built for,
+  // the owner is expected to reset it before the next use
+  inline void invalidate() { m_valid = false; }
+  inline bool valid() const { return m_valid; }
+
+  inline int count() const { return (int)m_order.size(); }
+  inline int numActive() const { return m_numAct; }
+
+  // returns the number of bytes allocated by the index
+  size_t memoryUsage() const
+  {
+    return (m_order.capacity() + m_pos.capacity()) * sizeof(int);
+  }
+
+  inline bool isActive(int id) const { return m_pos[id] < m_numAct; }
+
+  // returns the ID of the active element at position i < numActive() or
+  // of the inactive element at position i >= numActive()
+  inline int at(int i) const { return m_order[i]; }
+
+  // the order of the elements is left as it is
+  inline void actAll() { m_numAct = count(); }
+
+  void deact(int id)
+  {
+    if (!isActive(id))
+      return;
+    m_numAct--;
+    swapPositions(m_pos[id], m_numAct);
+  }
+};
+
+#endif // ACTSET_HEADER_FILE_INCLUDED
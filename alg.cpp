@@ -7,6 +7,8 @@
 
 #include "stdafx.h"
 #include "Graphs/alg.h"
+#include "Graphs/diropt.h"
+#include "Graphs/parallel.h"
 
 
 const double EPS0 = 1e-8;
@@ -16,70 +18,386 @@ double Alg::INF = 1e300;
 
 
 void Alg::CalcDistancesBFS(Node *src, const PNodeVector &nodes,
-                           bool activeOnly, bool forward)
+                           bool activeOnly, bool forward, int numThreads)
 {
   Alg::CalcDistancesBFS(src, &nodes[0], (int)nodes.size(), activeOnly,
-                        forward);
+                        forward, numThreads);
 }
 
 void Alg::CalcDistancesBFS(Node *src, Node * const *nodes, int count,
-                           bool activeOnly, bool forward)
+                           bool activeOnly, bool forward, int numThreads)
 {
-#if !defined(_DEBUG) && _MSC_VER >= 1600 && _MSC_VER < 1700
-  // queue implementation appears to be much slower in release mode
-  // than the priority queue implementation as tested in MS VS 2010
-  Alg::RunDijkstra(src, nodes, count, activeOnly, forward);
-#else
-  for (int j = 0; j < count; j++)
-    nodes[j]->m_dtag = -1;
+  AlgContext ctx(nodes, count);
+  Alg::CalcDistancesBFS(ctx, src, activeOnly, forward, numThreads);
+  ctx.storeDistances();
+}
 
-  if (activeOnly && src->m_dactTime >= 0)
-    return;
+void Alg::CalcDistancesBFS(AlgContext &ctx, Node *src,
+                           bool activeOnly, bool forward, int numThreads)
+{
+  Alg::RunBFS(ctx, src, activeOnly, forward, numThreads);
 
-  src->m_dtag = 0;
-  src->m_ntag = NULL;
+  const int count = ctx.count();
+  for (int i = 0; i < count; i++)
+    if (!ctx.reached(i))
+    {
+      ctx.m_dist[i] = -1;
+      ctx.m_prev[i] = -1;
+    }
+}
 
-  double max = 0;
-  Node *nMax = src;
+// returns the bounds of the part of [0; count) processed by a thread
+static inline void sg_ThreadSlice(int count, int thread, int numThreads,
+                                  int &beg, int &end)
+{
+  beg = (int)((long long)count * thread / numThreads);
+  end = (int)((long long)count * (thread + 1) / numThreads);
+}
 
-  PNodeList queue;
-  queue.push_back(src);
-  while (!queue.empty())
+// level-synchronous BFS whose levels are expanded by a group of threads,
+// the frontier is stored in the context's queue and split between
+// the threads in top-down steps, the nodes not reached yet are split in
+// bottom-up steps; nodes are claimed by atomic updates of their levels and
+// collected in per-thread buffers which are appended to the queue
+// in the thread order after each level
+// a node's parent is its frontier parent with the smallest index in
+// top-down steps and its first frontier parent in bottom-up steps, so that
+// the results do not depend on the number of threads
+class ParallelBFSTask : public IParallelTask
+{
+  AlgContext &m_ctx;
+  const int m_srcIx;
+  const bool m_activeOnly;
+  const bool m_forward;
+  const double m_length;
+
+  std::vector<std::atomic<int> > m_levels;
+  std::vector<std::atomic<int> > m_parents;
+  std::vector<std::vector<int> > m_buffers;
+  // per-thread partial sums of link counts
+  std::vector<double> m_frontierLinks;
+  std::vector<double> m_reachedLinks;
+  Barrier m_barrier;
+  int m_reached;
+
+  inline const LinkVector &childLinks(Node *n) const
+  {
+    return m_forward ? n->links() : n->inLinks();
+  }
+  inline const LinkVector &parentLinks(Node *n) const
   {
-    Node *n = queue.front();
-    queue.pop_front();
-    double curd = n->m_dtag;
+    return m_forward ? n->inLinks() : n->links();
+  }
 
-    LinkVector &links = forward ? n->links() : n->inLinks();
-    for (size_t j = 0; j < links.size(); j++)
+  void topDown(int level, int beg, int end, std::vector<int> &buffer)
+  {
+    const int *queue = m_ctx.m_queue.data();
+    for (int k = beg; k < end; k++)
     {
-      LinkData *l = links[j].d;
-      Node *n2 = links[j].n;
-      if (activeOnly && (l->m_dactTime >= 0 || n2->m_dactTime >= 0))
+      const int ix = queue[k];
+      const LinkVector &links = childLinks(m_ctx.node(ix));
+      for (size_t j = 0; j < links.size(); j++)
+      {
+        Node *n2 = links[j].n;
+        if (m_activeOnly && (links[j].d->m_dactTime >= 0 ||
+                             n2->m_dactTime >= 0))
+          continue;
+        const int ix2 = m_ctx.index(n2);
+        if (ix2 < 0)
+          continue;
+        std::atomic<int> &l2 = m_levels[ix2];
+        int expected = -1;
+        if (l2.load(std::memory_order_relaxed) == -1 &&
+            l2.compare_exchange_strong(expected, level + 1,
+                                       std::memory_order_relaxed))
+          buffer.push_back(ix2);
+        if (l2.load(std::memory_order_relaxed) != level + 1)
+          continue;
+        std::atomic<int> &p2 = m_parents[ix2];
+        int cur = p2.load(std::memory_order_relaxed);
+        while (ix < cur &&
+               !p2.compare_exchange_weak(cur, ix, std::memory_order_relaxed))
+          ;
+      }
+    }
+  }
+
+  void bottomUp(int level, int beg, int end, std::vector<int> &buffer)
+  {
+    for (int ix2 = beg; ix2 < end; ix2++)
+    {
+      if (m_levels[ix2].load(std::memory_order_relaxed) != -1)
         continue;
-      if (n2->m_dtag < 0)
+      Node *n2 = m_ctx.node(ix2);
+      if (m_activeOnly && n2->m_dactTime >= 0)
+        continue;
+      const LinkVector &links = parentLinks(n2);
+      for (size_t j = 0; j < links.size(); j++)
       {
-        n2->m_dtag = curd + l->m_length;
-        n2->m_ntag = n;
-        queue.push_back(n2);
+        const int ix = m_ctx.index(links[j].n);
+        if (ix < 0 || m_levels[ix].load(std::memory_order_relaxed) != level)
+          continue;
+        if (m_activeOnly && links[j].d->m_dactTime >= 0)
+          continue;
+        m_levels[ix2].store(level + 1, std::memory_order_relaxed);
+        m_parents[ix2].store(ix, std::memory_order_relaxed);
+        buffer.push_back(ix2);
+        break;
       }
-      else if (n2->m_dtag > curd + l->m_length)
-        throw Exception("Unsupported link lengths detected in a BFS paths "
-                        "calculation");
     }
   }
-#endif
+
+public:
+  ParallelBFSTask(AlgContext &ctx, int srcIx, bool activeOnly, bool forward,
+                  int numThreads)
+    : m_ctx(ctx), m_srcIx(srcIx), m_activeOnly(activeOnly),
+      m_forward(forward), m_length(ctx.uniformLength()),
+      m_levels(ctx.count()), m_parents(ctx.count()),
+      m_buffers(numThreads), m_frontierLinks(numThreads),
+      m_reachedLinks(numThreads), m_barrier(numThreads), m_reached(0)
+  {
+    ctx.m_queue[0] = srcIx;
+  }
+
+  // returns the number of the reached nodes listed in the context's queue
+  inline int reached() const { return m_reached; }
+
+  virtual void run(int thread, int numThreads)
+  {
+    const int count = m_ctx.count();
+    int beg, end;
+    sg_ThreadSlice(count, thread, numThreads, beg, end);
+    for (int i = beg; i < end; i++)
+    {
+      m_levels[i].store(i == m_srcIx ? 0 : -1, std::memory_order_relaxed);
+      m_parents[i].store(INT_MAX, std::memory_order_relaxed);
+    }
+    if (!m_barrier.wait())
+      return;
+
+    int *queue = m_ctx.m_queue.data();
+    Node *src = m_ctx.node(m_srcIx);
+    double unvisitedLinks = m_forward ?
+      m_ctx.numInLinks() - src->numInLinks() :
+      m_ctx.numLinks() - src->numLinks();
+    DirOptPolicy policy;
+    std::vector<int> &buffer = m_buffers[thread];
+
+    int levelBeg = 0, levelEnd = 1;
+    for (int level = 0; levelBeg < levelEnd; level++)
+    {
+      // every thread makes the same choice from the same sums
+      double links = 0;
+      sg_ThreadSlice(levelEnd - levelBeg, thread, numThreads, beg, end);
+      for (int k = levelBeg + beg; k < levelBeg + end; k++)
+        links += childLinks(m_ctx.node(queue[k])).size();
+      m_frontierLinks[thread] = links;
+      buffer.clear();
+      if (!m_barrier.wait())
+        return;
+      links = 0;
+      for (int t = 0; t < numThreads; t++)
+        links += m_frontierLinks[t];
+
+      if (policy.bottomUp(levelEnd - levelBeg, links, unvisitedLinks, count))
+      {
+        sg_ThreadSlice(count, thread, numThreads, beg, end);
+        bottomUp(level, beg, end, buffer);
+      }
+      else
+        topDown(level, levelBeg + beg, levelBeg + end, buffer);
+      if (!m_barrier.wait())
+        return;
+
+      int offset = levelEnd, total = 0;
+      for (int t = 0; t < numThreads; t++)
+      {
+        if (t == thread)
+          offset += total;
+        total += (int)m_buffers[t].size();
+      }
+      links = 0;
+      for (size_t k = 0; k < buffer.size(); k++)
+      {
+        const int ix = buffer[k];
+        const int prev = m_parents[ix].load(std::memory_order_relaxed);
+        queue[offset + k] = ix;
+        m_ctx.m_prev[ix] = prev;
+        m_ctx.m_dist[ix] = m_ctx.m_dist[prev] + m_length;
+        links += parentLinks(m_ctx.node(ix)).size();
+      }
+      m_reachedLinks[thread] = links;
+      if (!m_barrier.wait())
+        return;
+      for (int t = 0; t < numThreads; t++)
+        unvisitedLinks -= m_reachedLinks[t];
+
+      levelBeg = levelEnd;
+      levelEnd += total;
+    }
+    if (thread == 0)
+      m_reached = levelEnd;
+  }
+
+  virtual void cancel()
+  {
+    m_barrier.cancel();
+  }
+};
+
+int Alg::RunBFS(AlgContext &ctx, Node *src, bool activeOnly, bool forward,
+                int numThreads)
+{
+  // direction-optimizing BFS, bottom-up steps are taken only when
+  // the links between the bound nodes have equal positive lengths
+  ctx.startTraversal();
+  const int count = ctx.count();
+  std::vector<double> &dist = ctx.m_dist;
+  std::vector<int> &prev = ctx.m_prev;
+  int *queue = ctx.m_queue.data();
+  FrontierBitmap &front = ctx.m_front;
+
+  const int srcIx = ctx.index(src);
+  if (srcIx < 0 || (activeOnly && src->m_dactTime >= 0))
+    return 0;
+
+  dist[srcIx] = 0;
+  prev[srcIx] = -1;
+
+  numThreads = Parallel::NumThreads(numThreads);
+  if (numThreads > 1 && ctx.uniformLength() > 0)
+  {
+    ParallelBFSTask task(ctx, srcIx, activeOnly, forward, numThreads);
+    Parallel::Run(task, numThreads);
+    ctx.setReached(task.reached());
+    return ctx.m_reached;
+  }
+
+  ctx.reach(srcIx);
+
+  DirOptPolicy policy;
+  bool canBottomUp = true; // until the lengths are checked
+  double unvisitedLinks = forward ? ctx.numInLinks() - src->numInLinks() :
+                                    ctx.numLinks() - src->numLinks();
+
+  int head = 0;
+  while (head < ctx.m_reached)
+  {
+    const int levelEnd = ctx.m_reached;
+    bool bottomUp = false;
+    if (canBottomUp)
+    {
+      double frontierLinks = 0;
+      for (int k = head; k < levelEnd; k++)
+      {
+        Node *n = ctx.node(queue[k]);
+        frontierLinks += forward ? n->numLinks() : n->numInLinks();
+      }
+      bottomUp = policy.bottomUp(levelEnd - head, frontierLinks,
+                                 unvisitedLinks, count);
+      if (bottomUp && ctx.uniformLength() <= 0)
+        bottomUp = canBottomUp = false;
+    }
+
+    if (bottomUp)
+    {
+      if (front.size() < count)
+        front.reset(count);
+      for (int k = head; k < levelEnd; k++)
+        front.set(queue[k]);
+      for (int ix2 = 0; ix2 < count; ix2++)
+      {
+        Node *n2 = ctx.node(ix2);
+        if (ctx.reached(ix2) || (activeOnly && n2->m_dactTime >= 0))
+          continue;
+        const LinkVector &links = forward ? n2->inLinks() : n2->links();
+        for (size_t j = 0; j < links.size(); j++)
+        {
+          const int ix = ctx.index(links[j].n);
+          if (ix < 0 || !front.test(ix))
+            continue;
+          LinkData *l = links[j].d;
+          if (activeOnly && l->m_dactTime >= 0)
+            continue;
+          dist[ix2] = dist[ix] + l->m_length;
+          prev[ix2] = ix;
+          ctx.reach(ix2);
+          break;
+        }
+      }
+      for (; head < levelEnd; head++)
+        front.unset(queue[head]);
+    }
+    else
+      for (; head < levelEnd; head++)
+      {
+        const int ix = queue[head];
+        Node *n = ctx.node(ix);
+        double curd = dist[ix];
+
+        LinkVector &links = forward ? n->links() : n->inLinks();
+        for (size_t j = 0; j < links.size(); j++)
+        {
+          LinkData *l = links[j].d;
+          Node *n2 = links[j].n;
+          if (activeOnly && (l->m_dactTime >= 0 || n2->m_dactTime >= 0))
+            continue;
+          const int ix2 = ctx.index(n2);
+          if (ix2 < 0)
+            continue;
+          if (!ctx.reached(ix2))
+          {
+            dist[ix2] = curd + l->m_length;
+            prev[ix2] = ix;
+            ctx.reach(ix2);
+          }
+          else if (dist[ix2] > curd + l->m_length)
+            throw Exception("Unsupported link lengths detected in a BFS "
+                            "paths calculation");
+        }
+      }
+
+    for (int k = levelEnd; k < ctx.m_reached; k++)
+    {
+      Node *n = ctx.node(queue[k]);
+      unvisitedLinks -= forward ? n->numInLinks() : n->numLinks();
+    }
+  }
+  return ctx.m_reached;
 }
 
-void Alg::CalcPathToleranceBFS(Node *src, Node *dst,
-                               const PNodeVector &nodes,
-                               bool activeOnly)
+// runs a BFS or, if weighted is true, Dijkstra's algorithm from src
+static void sg_CalcDistances(AlgContext &ctx, Node *src, bool activeOnly,
+                             bool forward, bool weighted, int numThreads = 1)
+{
+  if (weighted)
+    Alg::RunDijkstra(ctx, src, activeOnly, forward);
+  else
+    Alg::CalcDistancesBFS(ctx, src, activeOnly, forward, numThreads);
+}
+
+// same as sg_CalcDistances but sets the distances only for the reached
+// nodes which are listed in the context's queue, returns their number
+static int sg_Traverse(AlgContext &ctx, Node *src, bool activeOnly,
+                       bool forward, bool weighted)
+{
+  if (!weighted)
+    return Alg::RunBFS(ctx, src, activeOnly, forward);
+  Alg::RunDijkstra(ctx, src, activeOnly, forward);
+  return ctx.m_reached;
+}
+
+static void sg_CalcPathTolerance(Node *src, Node *dst,
+                                 const PNodeVector &nodes, bool activeOnly,
+                                 bool weighted, int numThreads)
 {
   const size_t C = nodes.size();
 
-  Alg::CalcDistancesBFS(src, nodes, activeOnly, true);
+  AlgContext ctx(nodes);
+  sg_CalcDistances(ctx, src, activeOnly, true, weighted, numThreads);
 
-  if (dst->m_dtag < 0) // no path from src to dst
+  const int dstIx = ctx.index(dst);
+  if (dstIx < 0 || ctx.m_dist[dstIx] < 0) // no path from src to dst
   {
     for (size_t i = 0; i < C; i++)
       nodes[i]->m_pathTol = -1;
@@ -87,49 +405,87 @@ void Alg::CalcPathToleranceBFS(Node *src, Node *dst,
   }
 
   for (size_t i = 0; i < C; i++)
-  {
-    Node &n = *nodes[i];
-    n.m_pathTol = n.m_dtag;
-  }
+    nodes[i]->m_pathTol = ctx.m_dist[i];
 
-  Alg::CalcDistancesBFS(dst, nodes, activeOnly, false);
+  sg_CalcDistances(ctx, dst, activeOnly, false, weighted, numThreads);
 
   for (size_t i = 0; i < C; i++)
   {
     Node &n = *nodes[i];
-    if (n.m_pathTol < 0 || n.m_dtag < 0) // no path from src or no path to dst
+    double d = ctx.m_dist[i];
+    if (n.m_pathTol < 0 || d < 0) // no path from src or no path to dst
       n.m_pathTol = -1;
     else
-      n.m_pathTol = n.m_dtag + n.m_pathTol;
+      n.m_pathTol = d + n.m_pathTol;
   }
 }
 
+void Alg::CalcPathToleranceBFS(Node *src, Node *dst,
+                               const PNodeVector &nodes,
+                               bool activeOnly, int numThreads)
+{
+  sg_CalcPathTolerance(src, dst, nodes, activeOnly, false, numThreads);
+}
 
-double Alg::ApproxAvClssBFS(const PNodeVector &nodes, bool activeOnly)
+void Alg::CalcPathToleranceDijkstra(Node *src, Node *dst,
+                                    const PNodeVector &nodes,
+                                    bool activeOnly)
+{
+  sg_CalcPathTolerance(src, dst, nodes, activeOnly, true, 1);
+}
+
+
+static double sg_ApproxAvClss(const PNodeVector &nodes, bool activeOnly,
+                              bool weighted)
 {
-  int n = 0;
-  double sum = 0;
   int count = (int)nodes.size();
   int step = count > 1000 ? count / 1000 : 1;
+  std::vector<int> srcs;
   for (int i = 0; i < count; i += step)
-  {
-    Node &cur = *nodes[i];
+    if (!activeOnly || nodes[i]->m_dactTime < 0)
+      srcs.push_back(i);
+  const int n = (int)srcs.size();
 
-    if (activeOnly && cur.m_dactTime >= 0)
-      continue;
+  double sum = 0;
+  if (!weighted)
+  {
+    CsrGraph g;
+    Alg::BuildCsr(nodes, g);
+    std::vector<double> sums, invSums;
+    std::vector<int> reached;
+    Alg::CalcDistanceSumsBFS(g, srcs, activeOnly, false, sums, invSums,
+                             reached);
+    for (int i = 0; i < n; i++)
+      sum += invSums[i];
+    return sum / (n * count);
+  }
 
-    CalcDistancesBFS(&cur, &nodes[0], count, activeOnly, false);
-    for (int j = 0; j < count; j++)
+  AlgContext ctx(nodes);
+  for (int i = 0; i < n; i++)
+  {
+    // skip the source itself which is the first reached node
+    const int reached = sg_Traverse(ctx, nodes[srcs[i]], activeOnly, false,
+                                    weighted);
+    for (int k = 1; k < reached; k++)
     {
-      Node &nd = *nodes[j];
-      if (nd.m_dtag > 0)
-        sum += 1.0 / nd.m_dtag;
+      double d = ctx.m_dist[ctx.m_queue[k]];
+      if (d > 0)
+        sum += 1.0 / d;
     }
-    n ++;
-  }  
+  }
   return sum / (n * count);
 }
 
+double Alg::ApproxAvClssBFS(const PNodeVector &nodes, bool activeOnly)
+{
+  return sg_ApproxAvClss(nodes, activeOnly, false);
+}
+
+double Alg::ApproxAvClssDijkstra(const PNodeVector &nodes, bool activeOnly)
+{
+  return sg_ApproxAvClss(nodes, activeOnly, true);
+}
+
 
 #define INIT_PNODES_COMPID \
   int count = 0; \
@@ -138,242 +494,867 @@ double Alg::ApproxAvClssBFS(const PNodeVector &nodes, bool activeOnly)
   auto_del<Node *> del_pNodes(pNodes, true); \
   for (size_t i = 0; i < fCount; i++) \
     if (compId < 0 || compId == nodes[i]->m_compId) \
-    { \
       pNodes[count++] = nodes[i]; \
-      nodes[i]->m_tag = 0; \
-    }
+  AlgContext ctx(pNodes, count);
 
-double Alg::ApproxAvFarnessBFS(const PNodeVector &nodes, bool activeOnly,
-                               int compId)
+static double sg_ApproxAvFarness(const PNodeVector &nodes, bool activeOnly,
+                                 int compId, bool weighted)
 {
   INIT_PNODES_COMPID
 
-  int n = 0;
-  double sum = 0;
   int step = count > 1000 ? count / 1000 : 1;
+  std::vector<int> srcs;
   for (int i = 0; i < count; i += step)
+    srcs.push_back(i);
+  const int n = (int)srcs.size();
+
+  double sum = 0;
+  if (!weighted)
   {
-    Node *cur = pNodes[i];
-    CalcDistancesBFS(cur, pNodes, count, activeOnly, false);
-    for (int j = 0; j < count; j++)
+    CsrGraph g;
+    Alg::BuildCsr(pNodes, count, g);
+    std::vector<double> sums, invSums;
+    std::vector<int> reached;
+    Alg::CalcDistanceSumsBFS(g, srcs, activeOnly, false, sums, invSums,
+                             reached);
+    for (int i = 0; i < n; i++)
     {
-      Node &nd = *pNodes[j];
-      if (nd.m_dtag < 0)
+      if (reached[i] < count)
         throw Exception("The graph/component is not strongly connected");
-      sum += pNodes[j]->m_dtag;
+      sum += sums[i];
     }
-    n ++;
+    return sum / (n * count);
+  }
+
+  for (int i = 0; i < n; i++)
+  {
+    const int reached = sg_Traverse(ctx, pNodes[srcs[i]], activeOnly, false,
+                                    weighted);
+    if (reached < count)
+      throw Exception("The graph/component is not strongly connected");
+    for (int k = 0; k < reached; k++)
+      sum += ctx.m_dist[ctx.m_queue[k]];
   }
 
   return sum / (n * count);
 }
 
-double Alg::ApproxUDiameterBFS(const PNodeVector &nodes, bool activeOnly,
+double Alg::ApproxAvFarnessBFS(const PNodeVector &nodes, bool activeOnly,
                                int compId)
+{
+  return sg_ApproxAvFarness(nodes, activeOnly, compId, false);
+}
+
+double Alg::ApproxAvFarnessDijkstra(const PNodeVector &nodes,
+                                    bool activeOnly, int compId)
+{
+  return sg_ApproxAvFarness(nodes, activeOnly, compId, true);
+}
+
+static double sg_ApproxUDiameter(const PNodeVector &nodes, bool activeOnly,
+                                 int compId, bool weighted)
 {
   INIT_PNODES_COMPID
 
+  // marks of the nodes that have already been BFS sources
+  std::vector<int> &used = ctx.m_mark;
+  used.assign(count, 0);
+
   double D = -1;
-  Node *cur = pNodes[0];
-  cur->m_tag = 1;
+  int cur = 0;
+  used[cur] = 1;
   size_t hopsCount = 20;
   for (size_t h = 0; h < hopsCount; h++)
   {
-    CalcDistancesBFS(cur, pNodes, count, activeOnly, true);
-
-    if (h == 0)
+    const int reached = sg_Traverse(ctx, pNodes[cur], activeOnly, true,
+                                    weighted);
+    const std::vector<double> &dist = ctx.m_dist;
+
+    if (h == 0 && reached < count)
+      throw Exception("The graph/component is not strongly connected");
+
+    // the farthest node not used yet, the one with the smallest index
+    // among equally far nodes
+    int iMax = -1;
+    double max = -1;
+    for (int k = 0; k < reached; k++)
     {
-      for (int i = 0; i < count; i++)
-        if (pNodes[i]->m_dtag < 0)
-          throw Exception("The graph/component is not strongly connected");
-    }
-
-    Node *nMax;
-    double max = -1;    
-    for (int i = 0; i < count; i++)
-      if (pNodes[i]->m_dtag > max && pNodes[i]->m_tag == 0)
+      const int i = ctx.m_queue[k];
+      if (used[i] == 0 && (dist[i] > max || (dist[i] == max && i < iMax)))
       {
-        nMax = pNodes[i];
-        max = nMax->m_dtag;
+        iMax = i;
+        max = dist[i];
       }
+    }
     if (max > D)
       D = max;
     if (max < 0) // graph size is smaller than hopsCount
       break;
-    nMax->m_tag = 1;
-    cur = nMax;
+    used[iMax] = 1;
+    cur = iMax;
   }
   return D;
 }
 
+double Alg::ApproxUDiameterBFS(const PNodeVector &nodes, bool activeOnly,
+                               int compId)
+{
+  return sg_ApproxUDiameter(nodes, activeOnly, compId, false);
+}
 
-void Alg::CalcCentralitiesBFS(const PNodeVector &nodes, bool activeOnly,
-                              double *diam)
+double Alg::ApproxUDiameterDijkstra(const PNodeVector &nodes,
+                                    bool activeOnly, int compId)
+{
+  return sg_ApproxUDiameter(nodes, activeOnly, compId, true);
+}
+
+// runs a traversal from the node src and stores in far the farthest
+// reached node, the one with the smallest index among equally far nodes;
+// returns the eccentricity of src
+static double sg_Sweep(AlgContext &ctx, int src, bool activeOnly,
+                       bool weighted, int &far)
+{
+  const int reached = sg_Traverse(ctx, ctx.node(src), activeOnly, true,
+                                  weighted);
+  if (reached < ctx.count())
+    throw Exception("The graph/component is not connected");
+  const std::vector<double> &dist = ctx.m_dist;
+  far = src;
+  for (int k = 0; k < reached; k++)
+  {
+    const int i = ctx.m_queue[k];
+    if (dist[i] > dist[far] || (dist[i] == dist[far] && i < far))
+      far = i;
+  }
+  return dist[far];
+}
+
+// returns the node halfway on the path found by the last traversal from
+// its source to the node dst
+static int sg_Midpoint(const AlgContext &ctx, int dst)
+{
+  const double half = ctx.m_dist[dst] / 2;
+  int i = dst;
+  while (ctx.m_prev[i] >= 0 && ctx.m_dist[i] > half)
+    i = ctx.m_prev[i];
+  return i;
+}
+
+static double sg_CalcUDiameter(const PNodeVector &nodes, bool activeOnly,
+                               int compId, IBoundsProgress *progress,
+                               double *upper, bool weighted)
+{
+  INIT_PNODES_COMPID
+
+  double lb = 0, ub = count > 0 ? Alg::INF : 0;
+
+  int traversals = 0;
+  bool stopped = false;
+
+  // 4-sweep: double sweeps from the node of the largest degree and from
+  // the midpoint of the first double sweep's path
+  int u = 0;
+  for (int i = 1; i < count; i++)
+    if (pNodes[i]->numLinks() > pNodes[u]->numLinks())
+      u = i;
+  for (int s = 0; s < 2 && count > 0 && !stopped; s++)
+  {
+    int a, b;
+    lb = std::max(lb, sg_Sweep(ctx, u, activeOnly, weighted, a));
+    lb = std::max(lb, sg_Sweep(ctx, a, activeOnly, weighted, b));
+    traversals += 2;
+    u = sg_Midpoint(ctx, b);
+    stopped = progress != NULL && !progress->progress(lb, ub, traversals);
+  }
+
+  // the nodes by their distance from u in nondecreasing order
+  std::vector<int> fringe;
+  std::vector<double> fringeDist;
+  if (!stopped && count > 0)
+  {
+    int far;
+    const double ecc = sg_Sweep(ctx, u, activeOnly, weighted, far);
+    traversals++;
+    lb = std::max(lb, ecc);
+    ub = 2 * ecc;
+    fringe.assign(ctx.m_queue.begin(), ctx.m_queue.begin() + count);
+    fringeDist.resize(count);
+    for (int k = 0; k < count; k++)
+      fringeDist[k] = ctx.m_dist[fringe[k]];
+    stopped = progress != NULL && !progress->progress(lb, ub, traversals);
+  }
+
+  int k = count - 1;
+  while (!stopped && lb < ub)
+  {
+    int far;
+    lb = std::max(lb, sg_Sweep(ctx, fringe[k], activeOnly, weighted, far));
+    traversals++;
+    k--;
+    // once the nodes as far from u as the last one are done, the others
+    // are closer and the pairs of them at most twice as far apart
+    if (k < 0 || fringeDist[k] != fringeDist[k + 1])
+      ub = k >= 0 ? std::max(lb, 2 * fringeDist[k]) : lb;
+    stopped = progress != NULL && !progress->progress(lb, ub, traversals);
+  }
+
+  if (upper != NULL)
+    *upper = ub;
+  return lb;
+}
+
+double Alg::CalcUDiameterBFS(const PNodeVector &nodes, bool activeOnly,
+                             int compId, IBoundsProgress *progress,
+                             double *upper)
+{
+  return sg_CalcUDiameter(nodes, activeOnly, compId, progress, upper,
+                          false);
+}
+
+double Alg::CalcUDiameterDijkstra(const PNodeVector &nodes, bool activeOnly,
+                                  int compId, IBoundsProgress *progress,
+                                  double *upper)
+{
+  return sg_CalcUDiameter(nodes, activeOnly, compId, progress, upper, true);
+}
+
+static int sg_CalcEccentricities(const PNodeVector &nodes, bool activeOnly,
+                                 int compId, double *radius, double *diam,
+                                 PNodeVector *center, bool weighted)
+{
+  INIT_PNODES_COMPID
+
+  // bounds on the eccentricities and the nodes whose bounds still differ
+  std::vector<double> lower(count, 0), upper(count, Alg::INF);
+  std::vector<int> open;
+  open.reserve(count);
+
+  // the leaves linked to the same node by links of the same length have
+  // equal eccentricities, only the first of them is kept in open and
+  // the others copy its eccentricity from their representative in the end
+  std::vector<int> &rep = ctx.m_mark;
+  rep.assign(count, -1);
+  std::vector<int> firstLeaf(count, -1);
+  for (int i = 0; i < count; i++)
+  {
+    const LinkVector &links = pNodes[i]->links();
+    if (links.size() == 1)
+    {
+      const int nbr = ctx.index(links[0].n);
+      const int j = nbr >= 0 ? firstLeaf[nbr] : -1;
+      if (j >= 0 && nbr != i &&
+          pNodes[j]->links()[0].d->m_length == links[0].d->m_length)
+      {
+        rep[i] = j;
+        continue;
+      }
+      if (nbr >= 0 && j < 0)
+        firstLeaf[nbr] = i;
+    }
+    open.push_back(i);
+  }
+
+  // the BFS runs on a snapshot of the nodes
+  CsrGraph g;
+  std::vector<double> csrDist;
+  std::vector<int> csrPrev;
+  if (!weighted)
+    Alg::BuildCsr(pNodes, count, g);
+
+  int traversals = 0;
+  while (!open.empty())
+  {
+    // alternately the node of the largest upper bound and the node of
+    // the smallest lower bound, the one of the largest degree among
+    // the equal ones
+    const bool byUpper = traversals % 2 == 0;
+    int src = open[0];
+    for (size_t k = 1; k < open.size(); k++)
+    {
+      const int i = open[k];
+      const double b = byUpper ? upper[i] : -lower[i];
+      const double bSrc = byUpper ? upper[src] : -lower[src];
+      if (b > bSrc || (b == bSrc &&
+                       pNodes[i]->numLinks() > pNodes[src]->numLinks()))
+        src = i;
+    }
+
+    int reached = count;
+    const double *dist;
+    if (weighted)
+    {
+      reached = sg_Traverse(ctx, pNodes[src], activeOnly, true, true);
+      dist = ctx.m_dist.data();
+    }
+    else
+    {
+      Alg::CalcDistancesBFS(g, src, activeOnly, true, csrDist, csrPrev);
+      dist = csrDist.data();
+      for (int i = 0; i < count; i++)
+        if (dist[i] < 0)
+          reached--;
+    }
+    traversals++;
+    if (reached < count)
+      throw Exception("The graph/component is not connected");
+    double ecc = 0;
+    for (int i = 0; i < count; i++)
+      if (dist[i] > ecc)
+        ecc = dist[i];
+    lower[src] = upper[src] = ecc;
+
+    size_t kept = 0;
+    for (size_t k = 0; k < open.size(); k++)
+    {
+      const int i = open[k];
+      const double d = dist[i];
+      lower[i] = std::max(lower[i], std::max(d, ecc - d));
+      upper[i] = std::min(upper[i], ecc + d);
+      if (lower[i] < upper[i])
+        open[kept++] = i;
+    }
+    open.resize(kept);
+  }
+
+  double rad = count > 0 ? Alg::INF : 0, dmt = 0;
+  for (int i = 0; i < count; i++)
+  {
+    if (rep[i] >= 0)
+      lower[i] = lower[rep[i]];
+    pNodes[i]->m_ecc = lower[i];
+    rad = std::min(rad, lower[i]);
+    dmt = std::max(dmt, lower[i]);
+  }
+  if (radius != NULL)
+    *radius = rad;
+  if (diam != NULL)
+    *diam = dmt;
+  if (center != NULL)
+  {
+    center->clear();
+    for (int i = 0; i < count; i++)
+      if (lower[i] == rad)
+        center->push_back(pNodes[i]);
+  }
+  return traversals;
+}
+
+int Alg::CalcEccentricitiesBFS(const PNodeVector &nodes, bool activeOnly,
+                               int compId, double *radius, double *diam,
+                               PNodeVector *center)
+{
+  return sg_CalcEccentricities(nodes, activeOnly, compId, radius, diam,
+                               center, false);
+}
+
+int Alg::CalcEccentricitiesDijkstra(const PNodeVector &nodes,
+                                    bool activeOnly, int compId,
+                                    double *radius, double *diam,
+                                    PNodeVector *center)
+{
+  return sg_CalcEccentricities(nodes, activeOnly, compId, radius, diam,
+                               center, true);
+}
+
+
+static void sg_CalcCentralities(const PNodeVector &nodes, bool activeOnly,
+                                double *diam, int numThreads, bool weighted)
 {
   // if activeOnly is true:
-  //  - set all inactive nodes centralities to -1
   //  - set all inactive links centralities to -1
   //  - set all inactive nodes incident link centralities to -1
-  // copy relevant nodes to pNodes and save the number of active nodes as count
-  // initialize relevant nodes and links centralities to 0
-  int count = 0;
+  // initialize the other links centralities to 0, the links to nodes not
+  // in the array keep these values
   size_t fCount = nodes.size();
-  Node **pNodes = new Node *[fCount];
-  auto_del<Node *> del_pNodes(pNodes, true);
   for (size_t i = 0; i < fCount; i++)
   {
     Node *n = nodes[i];
     LinkVector &links = n->links();
-    LinkVector &inLinks = n->inLinks();
-    if (activeOnly && n->m_dactTime >= 0)
+    for (size_t j = 0; j < links.size(); j++)
     {
-      n->m_btws = n->m_clss = n->m_frns = -1;
-      for (size_t j = 0; j < links.size(); j++)
-        links[j].d->m_btws = -1;
-      for (size_t j = 0; j < inLinks.size(); j++)
-        links[j].d->m_btws = -1;
+      LinkData *ld = links[j].d;
+      ld->m_btws = activeOnly && ld->m_dactTime >= 0 ? -1 : 0;
     }
-    else
+  }
+  if (activeOnly)
+    for (size_t i = 0; i < fCount; i++)
     {
-      n->m_btws = n->m_clss = n->m_frns = 0;
-      pNodes[count++] = nodes[i];
+      Node *n = nodes[i];
+      if (n->m_dactTime < 0)
+        continue;
+      LinkVector &links = n->links();
+      LinkVector &inLinks = n->inLinks();
       for (size_t j = 0; j < links.size(); j++)
-      {
-        LinkData *ld = links[j].d;
-        if (activeOnly && ld->m_dactTime >= 0)
-          ld->m_btws = -1;
-        else
-          ld->m_btws = 0;
-      }
+        links[j].d->m_btws = -1;
+      for (size_t j = 0; j < inLinks.size(); j++)
+        inLinks[j].d->m_btws = -1;
     }
-  }
 
+  // the calculation runs on a snapshot of the nodes, which gives -1
+  // centralities to the inactive nodes and links as well
+  CsrGraph g;
+  Alg::BuildCsr(nodes, g);
+  std::vector<double> nodeBtws, clss, frns, linkBtws;
+  if (weighted)
+    Alg::CalcCentralitiesDijkstra(g, activeOnly, nodeBtws, clss, frns,
+                                  linkBtws, diam, numThreads);
+  else
+    Alg::CalcCentralitiesBFS(g, activeOnly, nodeBtws, clss, frns, linkBtws,
+                             diam, numThreads);
 
-  double d = 0; // temporary variable to store the diameter
-  for (int i = 0; i < count; i++)
+  for (size_t i = 0; i < fCount; i++)
   {
-    Node *cur = pNodes[i];
-    CalcDistancesBFS(cur, pNodes, count, activeOnly, false);
-
-    int ccSize = 1;
-    for (int j = 0; j < count; j++)
-    {
-      Node *src = pNodes[j];
-      if (cur == src || src->m_dtag < 0)
-        continue;
+    Node *n = nodes[i];
+    n->m_btws = nodeBtws[i];
+    n->m_clss = clss[i];
+    n->m_frns = frns[i];
+  }
+  for (size_t i = 0; i < linkBtws.size(); i++)
+    g.m_links[i]->m_btws = linkBtws[i];
+}
 
-      if (src->m_dtag > d)
-        d = src->m_dtag;
+void Alg::CalcCentralitiesBFS(const PNodeVector &nodes, bool activeOnly,
+                              double *diam, int numThreads)
+{
+  sg_CalcCentralities(nodes, activeOnly, diam, numThreads, false);
+}
 
-      cur->m_clss += 1.0 / src->m_dtag;
-      cur->m_frns += src->m_dtag;
-      ccSize++;
+void Alg::CalcCentralitiesDijkstra(const PNodeVector &nodes,
+                                   bool activeOnly, double *diam,
+                                   int numThreads)
+{
+  sg_CalcCentralities(nodes, activeOnly, diam, numThreads, true);
+}
 
-      Node *prv = src;
-      Node *nxt = prv->m_ntag;
-      while (nxt != cur)
-      {
-        LinkData *ld = prv->findLink(nxt);
-        ld->m_btws++;
-        nxt->m_btws++;
-        prv = nxt;
-        nxt = prv->m_ntag;
-      }
-      prv->findLink(nxt)->m_btws++;
-    }
+// stores the k nodes of the best closeness or farness in top and sets
+// their m_clss or m_frns
+static void sg_CalcTopCentralities(const PNodeVector &nodes, bool activeOnly,
+                                   int k, bool farness, PNodeVector &top)
+{
+  CsrGraph g;
+  Alg::BuildCsr(nodes, g);
+  std::vector<int> ixs;
+  std::vector<double> values;
+  if (farness)
+    Alg::CalcTopFrnsBFS(g, activeOnly, k, ixs, values);
+  else
+    Alg::CalcTopClssBFS(g, activeOnly, k, ixs, values);
 
-    cur->m_clss /= fCount;
-    cur->m_frns /= ccSize;
+  top.resize(ixs.size());
+  for (size_t i = 0; i < ixs.size(); i++)
+  {
+    Node *n = nodes[ixs[i]];
+    top[i] = n;
+    if (farness)
+      n->m_frns = values[i];
+    else
+      n->m_clss = values[i];
   }
-  if (diam != NULL)
-    *diam = d;
 }
 
+void Alg::CalcTopClssBFS(const PNodeVector &nodes, bool activeOnly, int k,
+                         PNodeVector &top)
+{
+  sg_CalcTopCentralities(nodes, activeOnly, k, false, top);
+}
 
-struct PQItemDijkstra
+void Alg::CalcTopFrnsBFS(const PNodeVector &nodes, bool activeOnly, int k,
+                         PNodeVector &top)
 {
-  Node *node;
-  double value;
-  bool operator< (const PQItemDijkstra &v) const
+  sg_CalcTopCentralities(nodes, activeOnly, k, true, top);
+}
+
+
+double Alg::ApproxBetweennessBFS(const PNodeVector &nodes, bool activeOnly,
+                                 double eps, double delta, int *samples)
+{
+  // links to nodes not in the array and links of inactive nodes are not
+  // in the snapshot and are initialized here
+  size_t fCount = nodes.size();
+  for (size_t i = 0; i < fCount; i++)
   {
-    return value > v.value;
+    Node *n = nodes[i];
+    bool dact = activeOnly && n->m_dactTime >= 0;
+    LinkVector &links = n->links();
+    LinkVector &inLinks = n->inLinks();
+    for (size_t j = 0; j < links.size(); j++)
+      links[j].d->m_btws = dact || (activeOnly &&
+                                    links[j].d->m_dactTime >= 0) ? -1 : 0;
+    if (dact)
+      for (size_t j = 0; j < inLinks.size(); j++)
+        inLinks[j].d->m_btws = -1;
   }
-};
+
+  CsrGraph g;
+  BuildCsr(nodes, g);
+  std::vector<double> nodeBtws, linkBtws;
+  double ret = ApproxBetweennessBFS(g, activeOnly, eps, delta, nodeBtws,
+                                    linkBtws, samples);
+
+  for (size_t i = 0; i < fCount; i++)
+    nodes[i]->m_btws = nodeBtws[i];
+  for (size_t i = 0; i < linkBtws.size(); i++)
+    g.m_links[i]->m_btws = linkBtws[i];
+  return ret;
+}
+
 
 void Alg::RunDijkstra(Node *src, Node * const *nodes, int count,
                       bool activeOnly, bool forward)
 {
-  for (int j = 0; j < count; j++)
-    nodes[j]->m_dtag = -1;
+  AlgContext ctx(nodes, count);
+  Alg::RunDijkstra(ctx, src, activeOnly, forward);
+  ctx.storeDistances();
+}
 
-  if (activeOnly && src->m_dactTime >= 0)
-    return;
+void Alg::RunDijkstra(Node *src, const PNodeVector &nodes, bool activeOnly,
+                      bool forward)
+{
+  Alg::RunDijkstra(src, &nodes[0], (int)nodes.size(), activeOnly, forward);
+}
 
-  std::priority_queue<PQItemDijkstra> heap;
+void Alg::RunDeltaStepping(Node *src, Node * const *nodes, int count,
+                           bool activeOnly, bool forward, int numThreads,
+                           double delta)
+{
+  AlgContext ctx(nodes, count);
+  const int srcIx = ctx.index(src);
+  std::vector<double> dist(count, -1);
+  std::vector<int> prev(count, -1);
+  if (srcIx >= 0)
+  {
+    CsrGraph g;
+    BuildCsr(nodes, count, g);
+    RunDeltaStepping(g, srcIx, activeOnly, forward, dist, prev, numThreads,
+                     delta);
+  }
 
-  src->m_dtag = 0;
-  PQItemDijkstra item = { src, 0 };
-  heap.push(item);
+  for (int i = 0; i < count; i++)
+  {
+    nodes[i]->m_dtag = dist[i];
+    nodes[i]->m_ntag = prev[i] >= 0 ? nodes[prev[i]] : NULL;
+  }
+}
 
-  while (heap.size() > 0)
+void Alg::RunDeltaStepping(Node *src, const PNodeVector &nodes,
+                           bool activeOnly, bool forward, int numThreads,
+                           double delta)
+{
+  Alg::RunDeltaStepping(src, &nodes[0], (int)nodes.size(), activeOnly,
+                        forward, numThreads, delta);
+}
+
+// returns the great-circle distance in kilometers between the points given
+// by their latitudes, longitudes and the cosines of their latitudes, in
+// radians (haversine formula)
+static inline double sg_GreatCircle(double lat1, double lng1, double cosLat1,
+                                    double lat2, double lng2, double cosLat2)
+{
+  const double EARTH_RADIUS = 6371.0088; // mean radius
+  const double sLat = sin((lat2 - lat1) / 2);
+  const double sLng = sin((lng2 - lng1) / 2);
+  const double a = sLat * sLat + cosLat1 * cosLat2 * sLng * sLng;
+  return 2 * EARTH_RADIUS * asin(a < 1 ? sqrt(a) : 1);
+}
+
+// lower bound on the length of a path from a node to the target node of
+// an A* search, the distance between the nodes' coordinates times
+// the length per unit of distance; the coordinates are planar or, if
+// geographic is true, latitudes and longitudes in degrees whose distance
+// is the great-circle distance in kilometers
+class CoordBound
+{
+  const Node *m_dst;
+  bool m_geographic;
+  double m_factor;
+  double m_cosLat;
+
+public:
+  CoordBound(const Node *dst, bool geographic, double lengthPerDist)
+    : m_dst(dst), m_geographic(geographic), m_factor(lengthPerDist),
+      m_cosLat(cos(dst->lat() * M_PI / 180))
   {
-    PQItemDijkstra top = heap.top();
-    heap.pop();
-    if (top.node->m_dtag < top.value)
+  }
+
+  static double distance(const Node *n1, const Node *n2, bool geographic)
+  {
+    if (!geographic)
+      return n1->m_coords.distance2D(n2->m_coords);
+    const double rad = M_PI / 180;
+    return sg_GreatCircle(n1->lat() * rad, n1->lng() * rad,
+                          cos(n1->lat() * rad), n2->lat() * rad,
+                          n2->lng() * rad, cos(n2->lat() * rad));
+  }
+
+  inline double operator()(const Node *n) const
+  {
+    if (m_factor <= 0)
+      return 0;
+    if (!m_geographic)
+      return m_factor * n->m_coords.distance2D(m_dst->m_coords);
+    const double rad = M_PI / 180;
+    return m_factor * sg_GreatCircle(n->lat() * rad, n->lng() * rad,
+                                     cos(n->lat() * rad),
+                                     m_dst->lat() * rad,
+                                     m_dst->lng() * rad, m_cosLat);
+  }
+};
+
+// labels the nodes linked to the settled node ix with the distances
+// through it; if other is not NULL, it is the context of the opposite
+// search of a bidirectional query whose shortest known path, of the length
+// best, is updated with the paths through the labelled nodes, meet being
+// set to the node where the two searches meet; if bound is not NULL,
+// the nodes are keyed by their distances plus the bound
+static inline void sg_RelaxLinks(AlgContext &ctx, int ix, bool activeOnly,
+                                 bool forward, const AlgContext *other,
+                                 double &best, int &meet,
+                                 const CoordBound *bound = NULL)
+{
+  std::vector<double> &dist = ctx.m_dist;
+  std::vector<int> &prev = ctx.m_prev;
+  DHeap &heap = ctx.m_heap;
+  const double curd = dist[ix];
+
+  Node *n = ctx.node(ix);
+  const LinkVector &links = forward ? n->links() : n->inLinks();
+  for (size_t j = 0; j < links.size(); j++)
+  {
+    Node *n2 = links[j].n;
+    LinkData *ld = links[j].d;
+    if (activeOnly && (ld->m_dactTime >= 0 || n2->m_dactTime >= 0))
+      continue;
+    const int ix2 = ctx.index(n2);
+    if (ix2 < 0 || ctx.reached(ix2))
+      continue;
+
+    const double d2 = curd + ld->m_length;
+    if (!heap.contains(ix2))
+      heap.push(ix2, bound != NULL ? d2 + (*bound)(n2) : d2);
+    else if (d2 < dist[ix2])
+      heap.decrease(ix2, heap.key(ix2) - dist[ix2] + d2);
+    else
       continue;
+    dist[ix2] = d2;
+    prev[ix2] = ix;
 
-    Node *topNode = top.node;
+    if (other != NULL && other->labelled(ix2) &&
+        d2 + other->m_dist[ix2] < best)
+    {
+      best = d2 + other->m_dist[ix2];
+      meet = ix2;
+    }
+  }
+}
 
-    LinkVector &links = forward ? topNode->links() : topNode->inLinks();
-    for (int i = 0; i < (int)links.size(); i++)
+// Dijkstra's algorithm from the node srcIx which stops once the node dstIx
+// is settled, runs to exhaustion if dstIx is -1; it is an A* search if
+// bound is not NULL
+static void sg_RunDijkstra(AlgContext &ctx, int srcIx, int dstIx,
+                           bool activeOnly, bool forward,
+                           const CoordBound *bound = NULL)
+{
+  DHeap &heap = ctx.m_heap;
+  ctx.m_dist[srcIx] = 0;
+  ctx.m_prev[srcIx] = -1;
+  heap.push(srcIx, 0);
+
+  double best = Alg::INF;
+  int meet = -1;
+  while (!heap.empty())
+  {
+    const int ix = heap.pop();
+    ctx.reach(ix);
+    if (ix == dstIx)
+      break;
+    sg_RelaxLinks(ctx, ix, activeOnly, forward, NULL, best, meet, bound);
+  }
+}
+
+void Alg::RunDijkstra(AlgContext &ctx, Node *src,
+                      bool activeOnly, bool forward)
+{
+  ctx.startTraversal();
+  const int srcIx = ctx.index(src);
+  if (srcIx >= 0 && (!activeOnly || src->m_dactTime < 0))
+    sg_RunDijkstra(ctx, srcIx, -1, activeOnly, forward);
+
+  const int count = ctx.count();
+  for (int i = 0; i < count; i++)
+    if (!ctx.reached(i))
     {
-      Node *n2 = links[i].n;
-      LinkData *ld = links[i].d;
-      if (activeOnly && (ld->m_dactTime >= 0 || n2->m_dactTime >= 0))
-        continue;
+      ctx.m_dist[i] = -1;
+      ctx.m_prev[i] = -1;
+    }
+}
+
+// appends to path the nodes from the node ix to the source of the last
+// traversal of ctx, or from the source if reverse is true
+static void sg_AppendPath(const AlgContext &ctx, int ix, bool reverse,
+                          PNodeVector &path)
+{
+  const size_t first = path.size();
+  for (; ix >= 0; ix = ctx.m_prev[ix])
+    path.push_back(ctx.node(ix));
+  if (reverse)
+    std::reverse(path.begin() + first, path.end());
+}
 
-      double n2Len = topNode->m_dtag + ld->m_length;
+double Alg::RunDijkstra(AlgContext &ctx, Node *src, Node *dst,
+                        bool activeOnly, PNodeVector *path)
+{
+  ctx.startTraversal();
+  if (path != NULL)
+    path->clear();
+  const int srcIx = ctx.index(src), dstIx = ctx.index(dst);
+  if (srcIx < 0 || dstIx < 0 ||
+      (activeOnly && (src->m_dactTime >= 0 || dst->m_dactTime >= 0)))
+    return -1;
+
+  sg_RunDijkstra(ctx, srcIx, dstIx, activeOnly, true);
+  if (!ctx.reached(dstIx))
+    return -1;
+  if (path != NULL)
+    sg_AppendPath(ctx, dstIx, true, *path);
+  return ctx.m_dist[dstIx];
+}
 
-      if (n2->m_dtag < 0 || n2Len < n2->m_dtag)
-      {
-        n2->m_dtag = n2Len;
-        PQItemDijkstra nItem = { n2, n2Len };
-        heap.push(nItem);
-      }
+double Alg::RunAStar(Node *src, Node *dst, const PNodeVector &nodes,
+                     bool activeOnly, bool geographic, double lengthPerDist)
+{
+  AlgContext ctx(nodes);
+  const double ret = Alg::RunAStar(ctx, src, dst, activeOnly, geographic,
+                                   lengthPerDist);
+  const int count = ctx.count();
+  for (int i = 0; i < count; i++)
+  {
+    Node *n = nodes[i];
+    const bool settled = ctx.reached(i);
+    n->m_dtag = settled ? ctx.m_dist[i] : -1;
+    n->m_ntag = settled ? ctx.prev(i) : NULL;
+  }
+  return ret;
+}
+
+double Alg::RunAStar(AlgContext &ctx, Node *src, Node *dst, bool activeOnly,
+                     bool geographic, double lengthPerDist,
+                     PNodeVector *path)
+{
+  ctx.startTraversal();
+  if (path != NULL)
+    path->clear();
+  const int srcIx = ctx.index(src), dstIx = ctx.index(dst);
+  if (srcIx < 0 || dstIx < 0 ||
+      (activeOnly && (src->m_dactTime >= 0 || dst->m_dactTime >= 0)))
+    return -1;
+
+  CoordBound bound(dst, geographic, lengthPerDist);
+  sg_RunDijkstra(ctx, srcIx, dstIx, activeOnly, true, &bound);
+  if (!ctx.reached(dstIx))
+    return -1;
+  if (path != NULL)
+    sg_AppendPath(ctx, dstIx, true, *path);
+  return ctx.m_dist[dstIx];
+}
+
+double Alg::CalcLengthPerDistance(const PNodeVector &nodes, bool geographic)
+{
+  double ret = Alg::INF;
+  for (size_t i = 0; i < nodes.size(); i++)
+  {
+    Node *n = nodes[i];
+    const LinkVector &links = n->links();
+    for (size_t j = 0; j < links.size(); j++)
+    {
+      const double d = CoordBound::distance(n, links[j].n, geographic);
+      if (d > 0 && links[j].d->m_length < ret * d)
+        ret = links[j].d->m_length / d;
     }
   }
+  // leave room for rounding errors in the bounds
+  return ret < Alg::INF && ret > 0 ? ret * (1 - 1e-9) : 0;
 }
 
-void Alg::RunDijkstra(Node *src, const PNodeVector &nodes, bool activeOnly,
-                      bool forward)
+double Alg::RunBidirDijkstra(AlgContext &fwd, AlgContext &bwd, Node *src,
+                             Node *dst, bool activeOnly, PNodeVector *path)
 {
-  Alg::RunDijkstra(src, &nodes[0], (int)nodes.size(), activeOnly, forward);
+  fwd.startTraversal();
+  bwd.startTraversal();
+  if (path != NULL)
+    path->clear();
+  const int srcIx = fwd.index(src), dstIx = bwd.index(dst);
+  if (srcIx < 0 || dstIx < 0 ||
+      (activeOnly && (src->m_dactTime >= 0 || dst->m_dactTime >= 0)))
+    return -1;
+
+  fwd.m_dist[srcIx] = bwd.m_dist[dstIx] = 0;
+  fwd.m_prev[srcIx] = bwd.m_prev[dstIx] = -1;
+  fwd.m_heap.push(srcIx, 0);
+  bwd.m_heap.push(dstIx, 0);
+  double best = srcIx == dstIx ? 0 : Alg::INF;
+  int meet = srcIx == dstIx ? srcIx : -1;
+
+  // the search with the closer unsettled node goes on until no path
+  // through unsettled nodes may be shorter than the best one found
+  while (!fwd.m_heap.empty() && !bwd.m_heap.empty() &&
+         fwd.m_heap.topKey() + bwd.m_heap.topKey() < best)
+  {
+    const bool forward = fwd.m_heap.topKey() <= bwd.m_heap.topKey();
+    AlgContext &ctx = forward ? fwd : bwd;
+    const int ix = ctx.m_heap.pop();
+    ctx.reach(ix);
+    sg_RelaxLinks(ctx, ix, activeOnly, forward, forward ? &bwd : &fwd,
+                  best, meet);
+  }
+
+  if (meet < 0)
+    return -1;
+  if (path != NULL)
+  {
+    sg_AppendPath(fwd, meet, true, *path);
+    sg_AppendPath(bwd, bwd.m_prev[meet], false, *path);
+  }
+  return best;
 }
 
 
 void Alg::RunBellmanFord(Node *src, Node * const *nodes, int count)
 {
+  AlgContext ctx(nodes, count);
+  Alg::RunBellmanFord(ctx, src);
+  ctx.storeDistances();
+}
+
+void Alg::RunBellmanFord(Node *src, const PNodeVector &nodes)
+{
+  Alg::RunBellmanFord(src, &nodes[0], (int)nodes.size());
+}
+
+void Alg::RunBellmanFord(AlgContext &ctx, Node *src)
+{
+  const int count = ctx.count();
   double *a = new double [2 * count];
   auto_del<double> del_a(a, true);
 
-  for (int i = 0; i < count; i++)
-    nodes[i]->m_tag = i;
+  ctx.m_prev.assign(count, -1);
   if (src != NULL)
   {
+    // nothing is reachable from a node not bound to the context
+    const int srcIx = ctx.index(src);
+    if (srcIx < 0)
+    {
+      ctx.m_dist.assign(count, INF);
+      return;
+    }
     for (int i = 0; i < count; i++)
       a[i] = INF;
-    a[src->m_tag] = 0;
-    src->m_ntag = NULL;
+    a[srcIx] = 0;
   }
   else
-  {
-    for (int i = 0; i < count; i++)
-      nodes[i]->m_ntag = NULL;
     memset(a, 0, count * sizeof(double));
-  }
 
-  bool updated;
-  int prevOffs, curOffs;
+  bool updated = false;
+  int prevOffs, curOffs = 0;
   for (int s = 1; s <= count; s++)
   {
     prevOffs = ((s + 1) % 2) * count;
@@ -381,25 +1362,25 @@ void Alg::RunBellmanFord(Node *src, Node * const *nodes, int count)
     updated = false;
     for (int j = 0; j < count; j++)
     {
-      Node *n = nodes[j];
-      const LinkVector &inLinks = n->inLinks();
+      const LinkVector &inLinks = ctx.node(j)->inLinks();
       double bestLength = a[j + prevOffs];
-      Node *bestFrom = NULL;
+      int bestFrom = -1;
       for (int k = 0; k < (int)inLinks.size(); k++)
       {
-        Node *from = inLinks[k].n;
-        double length = inLinks[k].d->m_length +
-                        a[from->m_tag + prevOffs];
+        const int from = ctx.index(inLinks[k].n);
+        if (from < 0)
+          continue;
+        double length = inLinks[k].d->m_length + a[from + prevOffs];
         if (length < bestLength)
         {
           bestLength = length;
           bestFrom = from;
         }
       }
-      if (bestFrom != NULL)
+      if (bestFrom >= 0)
       {
         updated = true;
-        n->m_ntag = bestFrom;
+        ctx.m_prev[j] = bestFrom;
       }
       a[j + curOffs] = bestLength;
     }
@@ -409,14 +1390,9 @@ void Alg::RunBellmanFord(Node *src, Node * const *nodes, int count)
   if (updated)
     throw Exception("A negative loop detected in Bellman-Ford");
 
-  for (int i = 0; i < count; i++)
-    nodes[i]->m_dtag = a[i + curOffs];
+  ctx.m_dist.assign(a + curOffs, a + curOffs + count);
 }
 
-void Alg::RunBellmanFord(Node *src, const PNodeVector &nodes)
-{
-  Alg::RunBellmanFord(src, &nodes[0], (int)nodes.size());
-}
 
 
 static void sg_PrintFWMatrix(double *a, int c)
@@ -448,9 +1424,8 @@ double Alg::RunFloydWarshall(Node * const *nodes, int count)
   double *a2 = new double [count * count];
   auto_del<double> del_a2(a2, true);
 
-  for (int i = 0; i < count; i++)
-    nodes[i]->m_tag = i;
-  
+  AlgContext ctx(nodes, count);
+
   for (int i = 0; i < count * count; i++)
     a1[i] = INF;
   for (int i = 0; i < count; i++)
@@ -458,7 +1433,11 @@ double Alg::RunFloydWarshall(Node * const *nodes, int count)
     a1[i + i * count] = 0;
     const LinkVector &links = nodes[i]->links();
     for (int j = 0; j < (int)links.size(); j++)
-      a1[i * count + links[j].n->m_tag] = links[j].d->m_length;
+    {
+      int ix = ctx.index(links[j].n);
+      if (ix >= 0)
+        a1[i * count + ix] = links[j].d->m_length;
+    }
   }
 
   //printf("Initial Matrix:" ENDL);
@@ -513,7 +1492,7 @@ double Alg::RunFloydWarshall(const PNodeVector &nodes)
 
 struct PQItemMST
 {
-  Node *node;
+  int node;
   LinkData *ld;
   double value;
   bool operator< (const PQItemMST &v) const
@@ -524,55 +1503,70 @@ struct PQItemMST
 
 double Alg::FindUMST(Node * const *nodes, int count, SrcLinkVector &ret)
 {
-  // node tags: -1: unseen; 0: queued; 1: added to the tree
+  AlgContext ctx(nodes, count);
+  return Alg::FindUMST(ctx, ret);
+}
+
+double Alg::FindUMST(const PNodeVector &nodes, SrcLinkVector &ret)
+{
+  return Alg::FindUMST(&nodes[0], (int)nodes.size(), ret);
+}
+
+double Alg::FindUMST(AlgContext &ctx, SrcLinkVector &ret)
+{
+  // node marks: -1: unseen; 0: queued; 1: added to the tree
+  // m_dist stores the cost of linking a queued node to the tree
   ret.clear();
   double totalCost = 0;
 
-  for (int j = 0; j < count; j++)
-    nodes[j]->m_tag = -1;
-
-  Node *start = nodes[0];
+  const int count = ctx.count();
+  std::vector<int> &mark = ctx.m_mark;
+  std::vector<double> &cost = ctx.m_dist;
+  std::vector<int> &prev = ctx.m_prev;
+  mark.assign(count, -1);
+  cost.assign(count, 0);
+  prev.assign(count, -1);
 
   std::priority_queue<PQItemMST> heap;
 
-  start->m_tag = 0;
-  start->m_dtag = 0;
-  start->m_ntag = NULL;
-  PQItemMST item = { start, NULL, 0 };
+  mark[0] = 0;
+  PQItemMST item = { 0, NULL, 0 };
   heap.push(item);
 
   while (heap.size() > 0)
   {
     PQItemMST top = heap.top();
     heap.pop();
-    if (top.node->m_dtag < top.value)
+    if (cost[top.node] < top.value)
       continue;
 
-    Node *topNode = top.node;
-    totalCost += topNode->m_dtag;
-    if (topNode->m_ntag != NULL)
+    Node *topNode = ctx.node(top.node);
+    totalCost += cost[top.node];
+    if (prev[top.node] >= 0)
     {
       SrcLink srcLink;
-      srcLink.src = topNode->m_ntag;
+      srcLink.src = ctx.node(prev[top.node]);
       srcLink.link.d = top.ld;
       srcLink.link.n = topNode;
       ret.push_back(srcLink);
     }
-    topNode->m_tag = 1;
+    mark[top.node] = 1;
 
     LinkVector &links = topNode->links();
     for (int i = 0; i < (int)links.size(); i++)
     {
-      Node *n2 = links[i].n;
+      const int ix2 = ctx.index(links[i].n);
       LinkData *ld = links[i].d;
+      if (ix2 < 0)
+        continue;
 
       // node is not in the tree and it's unseen or the current cost is better
-      if (n2->m_tag < 1 && (n2->m_tag < 0 || ld->m_weight < n2->m_dtag))
+      if (mark[ix2] < 1 && (mark[ix2] < 0 || ld->m_weight < cost[ix2]))
       {
-        n2->m_tag = 0;
-        n2->m_dtag = ld->m_weight;
-        n2->m_ntag = topNode;
-        PQItemMST nItem = { n2, ld, ld->m_weight };
+        mark[ix2] = 0;
+        cost[ix2] = ld->m_weight;
+        prev[ix2] = top.node;
+        PQItemMST nItem = { ix2, ld, ld->m_weight };
         heap.push(nItem);
       }
     }
@@ -585,11 +1579,6 @@ double Alg::FindUMST(Node * const *nodes, int count, SrcLinkVector &ret)
   return totalCost;
 }
 
-double Alg::FindUMST(const PNodeVector &nodes, SrcLinkVector &ret)
-{
-  return Alg::FindUMST(&nodes[0], (int)nodes.size(), ret);
-}
-
 
 double Alg::FindUMSTKruskal(const PNodeVector &nodes,
                             SrcLinkVector &srcLinks,
@@ -597,8 +1586,7 @@ double Alg::FindUMSTKruskal(const PNodeVector &nodes,
 {
   const int NC = (int)nodes.size();
   const int LC = (int)srcLinks.size();
-  for (int i = 0; i < NC; i++)
-    nodes[i]->m_tag = i;
+  AlgContext ctx(nodes);
 
   double totalCost = 0;
   UnionFind ufind(NC);
@@ -607,8 +1595,12 @@ double Alg::FindUMSTKruskal(const PNodeVector &nodes,
     SrcLink &srcLink = srcLinks[i];
     Node *n1 = srcLink.src;
     Node *n2 = srcLink.link.n;
-    int comp1 = ufind.find(n1->m_tag);
-    int comp2 = ufind.find(n2->m_tag);
+    int ix1 = ctx.index(n1);
+    int ix2 = ctx.index(n2);
+    if (ix1 < 0 || ix2 < 0)
+      continue;
+    int comp1 = ufind.find(ix1);
+    int comp2 = ufind.find(ix2);
     if (comp1 == comp2)
       continue;
     else
@@ -655,8 +1647,6 @@ void Alg::CalcUAvNNDegree(const PNodeVector &nodes)
 void Alg::CalcUClustering(const PNodeVector &nodes)
 {
   const int count = (int)nodes.size();
-  for (int i = 0; i < count; i++)
-    nodes[i]->m_tag = i;
   for (int i = 0; i < count; i++)
   {
     Node &n = *nodes[i];
@@ -672,7 +1662,7 @@ void Alg::CalcUClustering(const PNodeVector &nodes)
       for (size_t j = 0; j < ls.size(); j++)
       {
         Node *n2 = ls[j].n;
-        if (n1->m_tag < n2->m_tag && ret.find(n2) != ret.end())
+        if (n1 < n2 && ret.find(n2) != ret.end())
           cl++;
       }
     }
@@ -685,10 +1675,27 @@ void Alg::CalcUClustering(const PNodeVector &nodes)
 }
 
 
-static bool sg_compPNodeListsBySize(const PNodeList *list1,
-                                    const PNodeList *list2)
+int Alg::renumberComponents(std::vector<int> &compIds,
+                            std::vector<int> &compSizes)
 {
-  return list2->size() < list1->size();
+  // order components by decreasing size, and by their current IDs
+  // among equally sized ones
+  std::vector<std::pair<int, int> > order(compSizes.size());
+  for (size_t i = 0; i < order.size(); i++)
+    order[i] = std::make_pair(-compSizes[i], (int)i);
+  std::sort(order.begin(), order.end());
+
+  std::vector<int> rank(order.size());
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    rank[order[i].second] = (int)i;
+    compSizes[i] = -order[i].first;
+  }
+  for (size_t i = 0; i < compIds.size(); i++)
+    if (compIds[i] >= 0)
+      compIds[i] = rank[compIds[i]];
+
+  return compSizes.size() > 0 ? compSizes[0] : -1;
 }
 
 // macro is to simplify weak components calculation in directed networks
@@ -698,237 +1705,218 @@ static bool sg_compPNodeListsBySize(const PNodeList *list1,
     if (activeOnly && (_links)[i].d->m_dactTime >= 0) \
       continue; \
     Node *n2 = (_links)[i].n; \
-    if (n2->m_tag == 0) \
+    const int ix2 = ctx.index(n2); \
+    if (ix2 >= 0 && mark[ix2] == 0) \
     { \
-      queue.push_back(n2); \
-      n2->m_tag = 1; \
+      ctx.reach(ix2); \
+      mark[ix2] = 1; \
     } \
   }
 
+// macro is to share the traversal setup between the undirected and weak
+// components calculations
+#define INIT_CONNCOMP_MARKS \
+  const int count = ctx.count(); \
+  std::vector<int> &mark = ctx.m_mark; \
+  mark.resize(count); \
+  ctx.m_comp.assign(count, -1); \
+  ctx.m_compSizes.clear(); \
+  for (int i = 0; i < count; i++) \
+    mark[i] = (!activeOnly || ctx.node(i)->m_dactTime < 0) ? 0 : -1; \
+  ctx.startTraversal(); \
+  const int *queue = ctx.m_queue.data(); \
+  int head = 0;
+
 int Alg::AssignUComponentIDs(const PNodeVector &nodes, bool activeOnly)
 {
-  const size_t count = nodes.size();
-  for (size_t i = 0; i < count; i++)
-  {
-    Node &n = *nodes[i];
-    if (!activeOnly || n.m_dactTime < 0)
-      n.m_tag = 0;
-    else
-      n.m_tag = n.m_compId = -1;
-  }
+  AlgContext ctx(nodes);
+  int ret = Alg::AssignUComponentIDs(ctx, activeOnly);
+  ctx.storeComponents();
+  return ret;
+}
 
-  std::vector<PNodeList *> components;
-  PNodeList queue;
+int Alg::AssignUComponentIDs(AlgContext &ctx, bool activeOnly)
+{
+  INIT_CONNCOMP_MARKS
 
-  for (size_t i = 0; i < count; i++)
+  for (int ix = 0; ix < count; ix++)
   {
-    Node *n = nodes[i];
-    if (n->m_tag != 0)
+    if (mark[ix] != 0)
       continue;
 
-    queue.push_back(n);
-    n->m_tag = 1;
+    const int cid = (int)ctx.m_compSizes.size();
+    int size = 0;
 
-    PNodeList *current = new PNodeList();
+    ctx.reach(ix);
+    mark[ix] = 1;
 
-    while (!queue.empty())
+    while (head < ctx.m_reached)
     {
-      Node *qn = queue.front();
-      queue.pop_front();
+      const int qix = queue[head++];
+      Node *qn = ctx.node(qix);
 
-      current->push_back(qn);
+      ctx.m_comp[qix] = cid;
+      size++;
 
       const LinkVector &links = qn->links();
       const int linksSize = (int)links.size();
-      // add unvisited, active (tag == 0) nodes to the queue,
-      // and assign their tag to 1
+      // add unvisited, active (mark == 0) nodes to the queue,
+      // and assign their mark to 1
       PROCESS_CONNCOMP_LINKS(links, linksSize)
     }
 
-    components.push_back(current);
-  }
-
-  std::sort(components.begin(), components.end(), sg_compPNodeListsBySize);
-  int ret = components.size() > 0 ? (int)components[0]->size() : -1;
-
-  for (size_t i = 0; i < components.size(); i++)
-  {
-    PNodeList *lst = components[i];
-    for (PNodeList::iterator lit = lst->begin(); lit != lst->end(); lit++)
-    {
-      (*lit)->m_compId = (int)i;
-      (*lit)->m_compSize = lst->size();
-    }
-    delete lst;
+    ctx.m_compSizes.push_back(size);
   }
 
-  return ret;
+  return renumberComponents(ctx.m_comp, ctx.m_compSizes);
 }
 
 int Alg::AssignWkComponentIDs(const PNodeVector &nodes, bool activeOnly)
 {
-  const size_t count = nodes.size();
-  for (size_t i = 0; i < count; i++)
-  {
-    Node &n = *nodes[i];
-    if (!activeOnly || n.m_dactTime < 0)
-      n.m_tag = 0;
-    else
-      n.m_tag = n.m_compId = -1;
-  }
+  AlgContext ctx(nodes);
+  int ret = Alg::AssignWkComponentIDs(ctx, activeOnly);
+  ctx.storeComponents();
+  return ret;
+}
 
-  std::vector<PNodeList *> components;
-  PNodeList queue;
+int Alg::AssignWkComponentIDs(AlgContext &ctx, bool activeOnly)
+{
+  INIT_CONNCOMP_MARKS
 
-  for (size_t i = 0; i < count; i++)
+  for (int ix = 0; ix < count; ix++)
   {
-    Node *n = nodes[i];
-    if (n->m_tag != 0)
+    if (mark[ix] != 0)
       continue;
 
-    queue.push_back(n);
-    n->m_tag = 1;
+    const int cid = (int)ctx.m_compSizes.size();
+    int size = 0;
 
-    PNodeList *current = new PNodeList();
+    ctx.reach(ix);
+    mark[ix] = 1;
 
-    while (!queue.empty())
+    while (head < ctx.m_reached)
     {
-      Node *qn = queue.front();
-      queue.pop_front();
+      const int qix = queue[head++];
+      Node *qn = ctx.node(qix);
 
-      current->push_back(qn);
+      ctx.m_comp[qix] = cid;
+      size++;
 
       const LinkVector &links = qn->links();
       const int linksSize = (int)links.size();
-      // add unvisited, active (tag == 0) nodes to the queue,
-      // and assign their tag to 1
+      // add unvisited, active (mark == 0) nodes to the queue,
+      // and assign their mark to 1
       PROCESS_CONNCOMP_LINKS(links, linksSize)
 
       const LinkVector &inLinks = qn->inLinks();
       const int inLinksSize = (int)inLinks.size();
-      // add unvisited, active (tag == 0) nodes to the queue,
-      // and assign their tag to 1
+      // add unvisited, active (mark == 0) nodes to the queue,
+      // and assign their mark to 1
       PROCESS_CONNCOMP_LINKS(inLinks, inLinksSize)
     }
 
-    components.push_back(current);
+    ctx.m_compSizes.push_back(size);
   }
 
-  std::sort(components.begin(), components.end(), sg_compPNodeListsBySize);
-  int ret = components.size() > 0 ? (int)components[0]->size() : -1;
-
-  for (size_t i = 0; i < components.size(); i++)
-  {
-    PNodeList *lst = components[i];
-    for (PNodeList::iterator lit = lst->begin(); lit != lst->end(); lit++)
-    {
-      (*lit)->m_compId = (int)i;
-      (*lit)->m_compSize = lst->size();
-    }
-    delete lst;
-  }
+  return renumberComponents(ctx.m_comp, ctx.m_compSizes);
+}
 
+int Alg::AssignSgComponentIDs(const PNodeVector &nodes)
+{
+  AlgContext ctx(nodes);
+  int ret = Alg::AssignSgComponentIDs(ctx);
+  ctx.storeComponents();
   return ret;
 }
 
-int Alg::AssignSgComponentIDs(const PNodeVector &nodes)
+int Alg::AssignSgComponentIDs(AlgContext &ctx)
 {
-  for (size_t i = 0; i < nodes.size(); i++)
-    nodes[i]->m_tag = -1;
+  const int count = ctx.count();
+  std::vector<int> &mark = ctx.m_mark;
+  mark.assign(count, -1);
+  ctx.m_comp.assign(count, -1);
+  ctx.m_compSizes.clear();
 
   // Run backward DFS
-  // Node tags: -1: unseen; 0: added to the stack; 1: in-links added; 2: processed
-  PNodeList L;
-  PNodeStack S;
-  for (size_t i = 0; i < nodes.size(); i++)
+  // Node marks: -1: unseen; 0: added to the stack; 1: in-links added;
+  // 2: processed
+  // L stores the nodes in the reverse order of their processing
+  std::vector<int> L;
+  std::stack<int> S;
+  for (int i = 0; i < count; i++)
   {
-    Node &n = *nodes[i];
-    if (n.m_tag > 0)
+    if (mark[i] > 0)
       continue;
 
-    S.push(&n);
-    n.m_tag = 0;
+    S.push(i);
+    mark[i] = 0;
 
     while (S.size() > 0)
     {
-      Node *sn = S.top();
-      if (sn->m_tag > 1)
+      const int si = S.top();
+      if (mark[si] > 1)
         S.pop();
-      else if (sn->m_tag == 1)
+      else if (mark[si] == 1)
       {
         S.pop();
-        sn->m_tag = 2;
-        L.push_front(sn);
+        mark[si] = 2;
+        L.push_back(si);
       }
       else
       {
-        const LinkVector &iLinks = sn->inLinks();
+        const LinkVector &iLinks = ctx.node(si)->inLinks();
         for (size_t j = 0; j < iLinks.size(); j++)
         {
-          Node *src = iLinks[j].n;
-          if (src->m_tag <= 0)
+          const int src = ctx.index(iLinks[j].n);
+          if (src >= 0 && mark[src] <= 0)
           {
             S.push(src);
-            src->m_tag = 0;
+            mark[src] = 0;
           }
         }
-        sn->m_tag = 1;
+        mark[si] = 1;
       }
     }
   }
 
   // Run forward BFS
-  // Node tags: 2: unseen; 3: processed
-  PNodeQueue Q;
-  std::map<Node *, PNodeList *> D;
-  for (PNodeList::iterator it = L.begin(); it != L.end(); it++)
+  // Node marks: 2: unseen; 3: processed
+  std::queue<int> Q;
+  for (std::vector<int>::reverse_iterator it = L.rbegin();
+       it != L.rend(); it++)
   {
-    Node *n = *it;
-    if (n->m_tag > 2)
+    const int li = *it;
+    if (mark[li] > 2)
       continue;
 
-    PNodeList *l = new PNodeList();
-    D[n] = l;
+    const int cid = (int)ctx.m_compSizes.size();
+    int size = 0;
 
-    Q.push(n);
-    n->m_tag = 3;
-    l->push_back(n);
+    Q.push(li);
+    mark[li] = 3;
+    ctx.m_comp[li] = cid;
+    size++;
 
     while (Q.size() > 0)
     {
-      Node *sn = Q.front();
+      const int si = Q.front();
       Q.pop();
-      const LinkVector &links = sn->links();
+      const LinkVector &links = ctx.node(si)->links();
       for (size_t j = 0; j < links.size(); j++)
       {
-        Node *dst = links[j].n;
-        if (dst->m_tag <= 2)
+        const int dst = ctx.index(links[j].n);
+        if (dst >= 0 && mark[dst] <= 2)
         {
           Q.push(dst);
-          dst->m_tag = 3;
-          l->push_back(dst);
+          mark[dst] = 3;
+          ctx.m_comp[dst] = cid;
+          size++;
         }
       }
     }
-  }
 
-  std::vector<PNodeList *> components;
-  for (std::map<Node *, PNodeList *>::iterator mit = D.begin();
-       mit != D.end(); mit++)
-    components.push_back(mit->second);
-  std::sort(components.begin(), components.end(), sg_compPNodeListsBySize);
-  int ret = components.size() > 0 ? (int)components[0]->size() : -1;
-
-  for (size_t i = 0; i < components.size(); i++)
-  {
-    PNodeList *lst = components[i];
-    for (PNodeList::iterator lit = lst->begin(); lit != lst->end(); lit++)
-    {
-      (*lit)->m_compId = (int)i;
-      (*lit)->m_compSize = lst->size();
-    }
-    delete lst;
+    ctx.m_compSizes.push_back(size);
   }
 
-  return ret;
+  return renumberComponents(ctx.m_comp, ctx.m_compSizes);
 }
@@ -6,12 +6,34 @@
 */
 
 #include "node.h"
+#include "csrgraph.h"
+#include "algcontext.h"
 
 #ifndef ALG_HEADER_FILE_INCLUDED
 #define ALG_HEADER_FILE_INCLUDED
 
+/*
+  Receives the bounds of a quantity refined by an Alg routine, e.g.
+  the diameter of a graph, after each traversal of the graph
+*/
+class LIBGRAPHS_API IBoundsProgress
+{
+public:
+  virtual ~IBoundsProgress() {}
+
+  // lower and upper are the current bounds, traversals is the number of
+  // traversals run so far; returns false to stop the refinement
+  virtual bool progress(double lower, double upper, int traversals) = 0;
+};
+
 class LIBGRAPHS_API Alg
 {
+protected:
+  // renumbers components by decreasing size, returns the largest size
+  // or -1 if there are no components
+  static int renumberComponents(std::vector<int> &compIds,
+                                std::vector<int> &compSizes);
+
 public:
   static double INF;
 
@@ -19,18 +41,40 @@ public:
   // and m_dtag to store the distance from src to the node
   // follows a node's incoming links if forward is false
   // throws an exception if unequal link lengths are detected
+  // if the links have equal lengths, each level is expanded by numThreads
+  // threads (the number of hardware threads if numThreads is not positive),
+  // the distances do not depend on the number of threads, the incoming link
+  // nodes may differ from those of a single-threaded call but are the same
+  // for any larger number of threads
   static void CalcDistancesBFS(Node *src, Node * const *nodes, int count,
-                               bool activeOnly, bool forward);
+                               bool activeOnly, bool forward,
+                               int numThreads = 1);
   // wrapper function for the previous one
   static void CalcDistancesBFS(Node *src, const PNodeVector &nodes,
-                               bool activeOnly, bool forward);
+                               bool activeOnly, bool forward,
+                               int numThreads = 1);
+  // stores the distances and the immediate incoming link nodes in m_dist and
+  // m_prev of the context rather than in the nodes, only the nodes bound to
+  // the context are visited
+  static void CalcDistancesBFS(AlgContext &ctx, Node *src,
+                               bool activeOnly, bool forward,
+                               int numThreads = 1);
+  // same as the previous one but sets m_dist and m_prev of the context only
+  // for the reached nodes, which are listed in the visit order in m_queue
+  // of the context, returns their number; allocates no memory and takes no
+  // time proportional to the number of bound nodes on repeated calls with
+  // the same context, except in bottom-up steps over large frontiers and
+  // in calls with several threads
+  static int RunBFS(AlgContext &ctx, Node *src, bool activeOnly,
+                    bool forward, int numThreads = 1);
 
   // updates m_pathTol, -1 implies that a node is not on the path,
   // termini are considered a part of the path
   // throws an exception if unequal link lengths are detected
+  // the BFS steps are run by numThreads threads as in CalcDistancesBFS
   static void CalcPathToleranceBFS(Node *src, Node *dst,
                                    const PNodeVector &nodes,
-                                   bool activeOnly);
+                                   bool activeOnly, int numThreads = 1);
 
   // throws an exception if unequal link lengths are detected
   static double ApproxAvClssBFS(const PNodeVector &nodes, bool activeOnly);
@@ -46,6 +90,74 @@ public:
   static double ApproxUDiameterBFS(const PNodeVector &nodes, bool activeOnly,
                                    int compId = -1);
 
+  // counterparts of the above four functions for links of arbitrary
+  // nonnegative lengths, the distances are calculated with Dijkstra's
+  // algorithm
+  static void CalcPathToleranceDijkstra(Node *src, Node *dst,
+                                        const PNodeVector &nodes,
+                                        bool activeOnly);
+  static double ApproxAvClssDijkstra(const PNodeVector &nodes,
+                                     bool activeOnly);
+  static double ApproxAvFarnessDijkstra(const PNodeVector &nodes,
+                                        bool activeOnly, int compId = -1);
+  static double ApproxUDiameterDijkstra(const PNodeVector &nodes,
+                                        bool activeOnly, int compId = -1);
+
+  /*
+    Calculates the exact diameter of an undirected graph/component with
+    the iterative fringe upper bound algorithm (iFUB, Crescenzi et al.)
+    Traversals from the ends of two double sweeps give a lower bound and
+    a central node u; the nodes are then traversed in decreasing order
+    of their distance from u, after the nodes at the distance d are done
+    twice the next smaller distance bounds the diameter from above
+    On real networks only a few traversals are usually needed, O(nm) time
+    in the worst case
+    If progress is not NULL, it receives the bounds after each traversal and
+    may stop the calculation, the lower bound is then returned
+    The upper bound is stored in upper, it equals the returned value unless
+    the calculation is stopped
+    If graph/component is not (optionally, actively) connected, an exception
+    will be thrown
+    Throws an exception if unequal link lengths are detected
+  */
+  static double CalcUDiameterBFS(const PNodeVector &nodes, bool activeOnly,
+                                 int compId = -1,
+                                 IBoundsProgress *progress = NULL,
+                                 double *upper = NULL);
+  // same as CalcUDiameterBFS but for links of arbitrary nonnegative lengths
+  static double CalcUDiameterDijkstra(const PNodeVector &nodes,
+                                      bool activeOnly, int compId = -1,
+                                      IBoundsProgress *progress = NULL,
+                                      double *upper = NULL);
+
+  /*
+    Calculates the eccentricities of the nodes of an undirected
+    graph/component and stores them in m_ecc, other nodes are not modified
+    Every node keeps lower and upper bounds on its eccentricity, which are
+    tightened by each traversal through the triangle inequality (Takes and
+    Kosters); sources are chosen alternately among the nodes of the largest
+    upper and of the smallest lower bound, most nodes are resolved without
+    a traversal of their own
+    The radius, the diameter and the center (the nodes of the eccentricity
+    equal to the radius) are stored in radius, diam and center if they are
+    not NULL
+    Returns the number of traversals run
+    If graph/component is not (optionally, actively) connected, an exception
+    will be thrown
+    Throws an exception if unequal link lengths are detected
+  */
+  static int CalcEccentricitiesBFS(const PNodeVector &nodes, bool activeOnly,
+                                   int compId = -1, double *radius = NULL,
+                                   double *diam = NULL,
+                                   PNodeVector *center = NULL);
+  // same as CalcEccentricitiesBFS but for links of arbitrary nonnegative
+  // lengths
+  static int CalcEccentricitiesDijkstra(const PNodeVector &nodes,
+                                        bool activeOnly, int compId = -1,
+                                        double *radius = NULL,
+                                        double *diam = NULL,
+                                        PNodeVector *center = NULL);
+
   /*
     Calculates node betweenness, closeness, and farness centralities
     Calculates link betweenness centrality
@@ -54,13 +166,65 @@ public:
     Centralities for inactive nodes and links are set to -1
     Centralities for links incident on inactive nodes are set to -1
     Throws an exception if unequal link lengths are detected
+    Betweenness centralities are calculated with Brandes' algorithm in
+    O(nm) time, each ordered pair of nodes contributes the fraction of its
+    shortest paths passing through a node or a link
     Betweenness centralities are not normalized
     Closeness centralities are normalized on the count of nodes
     Farness centralities are normalized on the node's connected component size
     \diam is set to the largest distance between any connected pair of nodes
+    Sources are distributed over numThreads threads (the number of hardware
+    threads if numThreads is not positive), the results do not depend on
+    the number of threads
+    Links to nodes not in the array are ignored
   */
   static void CalcCentralitiesBFS(const PNodeVector &nodes, bool activeOnly,
-                                  double *diam = NULL);
+                                  double *diam = NULL, int numThreads = 1);
+  // same as CalcCentralitiesBFS but for links of arbitrary positive lengths,
+  // shortest paths are counted with Dijkstra's algorithm in O(nm + n^2 log n)
+  // time, throws an exception if an active link of a nonpositive length is
+  // detected
+  static void CalcCentralitiesDijkstra(const PNodeVector &nodes,
+                                       bool activeOnly, double *diam = NULL,
+                                       int numThreads = 1);
+
+  /*
+    Finds the k nodes of the largest closeness centralities, as defined
+    in CalcCentralitiesBFS, without calculating the others
+    The nodes are traversed in the order of decreasing in-degrees, a BFS
+    stops early once an upper bound on the node's closeness drops below
+    the k-th largest one found so far (Bergamini et al.)
+    Supports a directed or undirected possibly not connected graph
+    top is set to the nodes in the order of decreasing closeness, nodes of
+    equal closeness in the order of the array, only their m_clss are set
+    Inactive nodes are not considered if activeOnly is true
+    Throws an exception if unequal link lengths are detected
+  */
+  static void CalcTopClssBFS(const PNodeVector &nodes, bool activeOnly,
+                             int k, PNodeVector &top);
+  // same as CalcTopClssBFS but finds the k nodes of the smallest farness
+  // centralities and sets their m_frns, i.e. the classic closeness
+  // centrality; if the graph is not (optionally, actively) strongly
+  // connected, an exception may be thrown
+  static void CalcTopFrnsBFS(const PNodeVector &nodes, bool activeOnly,
+                             int k, PNodeVector &top);
+
+  /*
+    Estimates node and link betweenness centralities by sampling shortest
+    paths between random pairs of nodes (Riondato and Kornaropoulos)
+    With the probability at least 1 - delta every estimate differs from
+    the betweenness normalized on the number of ordered pairs of nodes by
+    at most eps; the estimates are stored scaled back to the scale of
+    CalcCentralitiesBFS
+    The sampling stops early once empirical Bernstein bounds on all
+    estimates drop to eps, the achieved bound (at most eps) is returned
+    and the number of sampled pairs is stored in samples
+    Inactive nodes and links are treated as in CalcCentralitiesBFS
+    Throws an exception if unequal link lengths are detected
+  */
+  static double ApproxBetweennessBFS(const PNodeVector &nodes,
+                                     bool activeOnly, double eps,
+                                     double delta, int *samples = NULL);
 
   // uses m_ntag to store an immediate incoming link node on the shortest path,
   // and m_dtag to store the distance from src to the node
@@ -70,6 +234,73 @@ public:
   // wrapper function for the previous one
   static void RunDijkstra(Node *src, const PNodeVector &nodes,
                           bool activeOnly, bool forward);
+  // stores the results in m_dist and m_prev of the context and lists
+  // the reached nodes in the order of nondecreasing distances in m_queue
+  static void RunDijkstra(AlgContext &ctx, Node *src,
+                          bool activeOnly, bool forward);
+  // same output as RunDijkstra above computed by the delta-stepping
+  // algorithm on numThreads threads (the number of hardware threads if
+  // numThreads is not positive) on a snapshot of the nodes; the nodes are
+  // kept in buckets of tentative distances of width delta, which is
+  // chosen from the link lengths if it is not positive; the distances do
+  // not depend on the number of threads, nor do the parents unless there
+  // are links of zero length; throws an exception if a link of a negative
+  // length is detected
+  static void RunDeltaStepping(Node *src, Node * const *nodes, int count,
+                               bool activeOnly, bool forward,
+                               int numThreads = 1, double delta = 0);
+  // wrapper function for the previous one
+  static void RunDeltaStepping(Node *src, const PNodeVector &nodes,
+                               bool activeOnly, bool forward,
+                               int numThreads = 1, double delta = 0);
+  // point-to-point query which stops once dst is settled, returns
+  // the distance from src to dst or -1 if dst is not reachable and stores
+  // the path from src to dst in path if it is not NULL; m_dist and m_prev of
+  // the context are set only for the nodes listed in m_queue or left in
+  // m_heap, so that a query takes no time proportional to the number of
+  // bound nodes on repeated calls with the same context
+  static double RunDijkstra(AlgContext &ctx, Node *src, Node *dst,
+                            bool activeOnly, PNodeVector *path = NULL);
+  // same as the previous one but the query is bidirectional: fwd searches
+  // forward from src and bwd backward from dst over incoming links, always
+  // advancing the search whose closest unsettled node is closer, until
+  // the two closest unsettled nodes are farther apart than the shortest
+  // path found; fwd and bwd must be distinct contexts bound to the same
+  // nodes
+  static double RunBidirDijkstra(AlgContext &fwd, AlgContext &bwd,
+                                 Node *src, Node *dst, bool activeOnly,
+                                 PNodeVector *path = NULL);
+
+  /*
+    A* search from src to dst guided by a lower bound on the length of
+    a path from a node to dst, the distance between the coordinates of
+    the nodes (m_coords) times lengthPerDist
+    The coordinates are planar, or latitudes and longitudes in degrees if
+    geographic is true, their distance is then the great-circle distance
+    in kilometers
+    The result is exact if no link is shorter than lengthPerDist times
+    the distance between its nodes, CalcLengthPerDistance returns
+    the largest such factor; a nonpositive factor makes it a Dijkstra's
+    point-to-point query
+    Uses m_ntag and m_dtag as RunDijkstra for the nodes settled by
+    the search, the other nodes get -1 and NULL, dst is traced back to src
+    over m_ntag
+    Returns the distance from src to dst or -1 if dst is not reachable
+  */
+  static double RunAStar(Node *src, Node *dst, const PNodeVector &nodes,
+                         bool activeOnly, bool geographic,
+                         double lengthPerDist);
+  // same as the previous one but the results are stored in the context as
+  // by the point-to-point RunDijkstra above, the path from src to dst is
+  // stored in path if it is not NULL
+  static double RunAStar(AlgContext &ctx, Node *src, Node *dst,
+                         bool activeOnly, bool geographic,
+                         double lengthPerDist, PNodeVector *path = NULL);
+  // returns the largest factor for which the lower bound of RunAStar is
+  // valid with the lengths of the links between the nodes, 0 if there is
+  // no such positive factor
+  static double CalcLengthPerDistance(const PNodeVector &nodes,
+                                      bool geographic);
 
   // draft implementation of the Bellman-Ford algorithm for the single source
   // shortest path problem in graphs with potentially negative link lengths
@@ -79,6 +310,10 @@ public:
   static void RunBellmanFord(Node *src, Node * const *nodes, int count);
   // wrapper function for the previous one
   static void RunBellmanFord(Node *src, const PNodeVector &nodes);
+  // stores the results in m_dist and m_prev of the context,
+  // m_dist is set to INF for the nodes not reachable from src, for all
+  // nodes if src is not bound to the context
+  static void RunBellmanFord(AlgContext &ctx, Node *src);
 
   // draft implementation of the Floyd-Warshall algorithm for the all pairs
   // shortest path problem in graphs with potentially negative link lengths
@@ -94,6 +329,8 @@ public:
   static double FindUMST(Node * const *nodes, int count, SrcLinkVector &ret);
   // wrapper function for the previous one
   static double FindUMST(const PNodeVector &nodes, SrcLinkVector &ret);
+  // uses m_mark, m_dist, and m_prev of the context as working storage
+  static double FindUMST(AlgContext &ctx, SrcLinkVector &ret);
 
   // finds a minimum spanning tree of an undirected graph with link costs
   // given by their weights, throws an exception if the graph is not connected
@@ -108,6 +345,99 @@ public:
   static int AssignUComponentIDs(const PNodeVector &nodes, bool activeOnly);
   static int AssignWkComponentIDs(const PNodeVector &nodes, bool activeOnly);
   static int AssignSgComponentIDs(const PNodeVector &nodes);
+  // store the component IDs and sizes in m_comp and m_compSizes of
+  // the context rather than in m_compId and m_compSize of the nodes
+  static int AssignUComponentIDs(AlgContext &ctx, bool activeOnly);
+  static int AssignWkComponentIDs(AlgContext &ctx, bool activeOnly);
+  static int AssignSgComponentIDs(AlgContext &ctx);
+
+  /*
+    Overloads running on a CsrGraph snapshot (see Graph::freeze)
+    Nodes and links are referred to by their snapshot indices and
+    the results are stored in the output vectors rather than in the node
+    and link fields, the snapshot itself is never modified
+  */
+
+  // dist is set to the distance from src to a node or to -1 if the node is
+  // not reachable, prev to the index of an immediate incoming link node on
+  // a shortest path or to -1
+  // throws an exception if unequal link lengths are detected
+  static void CalcDistancesBFS(const CsrGraph &g, int src, bool activeOnly,
+                               bool forward, std::vector<double> &dist,
+                               std::vector<int> &prev);
+
+  // runs a BFS from each node in srcs and stores the sum of the distances
+  // to the reached nodes in sums, the sum of their inverses in invSums, and
+  // the number of reached nodes including the source in reached; when all
+  // links have equal lengths 64 sources are advanced at a time with one
+  // scan of the links, otherwise throws an exception if unequal link
+  // lengths are detected
+  static void CalcDistanceSumsBFS(const CsrGraph &g,
+                                  const std::vector<int> &srcs,
+                                  bool activeOnly, bool forward,
+                                  std::vector<double> &sums,
+                                  std::vector<double> &invSums,
+                                  std::vector<int> &reached);
+
+  // outputs are as in the BFS overload above
+  static void RunDijkstra(const CsrGraph &g, int src, bool activeOnly,
+                          bool forward, std::vector<double> &dist,
+                          std::vector<int> &prev);
+  // same as RunDeltaStepping above, the outputs are as in the BFS overload
+  // above
+  static void RunDeltaStepping(const CsrGraph &g, int src, bool activeOnly,
+                               bool forward, std::vector<double> &dist,
+                               std::vector<int> &prev, int numThreads = 1,
+                               double delta = 0);
+
+  // same as CalcCentralitiesBFS and CalcCentralitiesDijkstra above, nodeBtws,
+  // clss, and frns are indexed by the node, linkBtws by the link snapshot
+  // index
+  static void CalcCentralitiesBFS(const CsrGraph &g, bool activeOnly,
+                                  std::vector<double> &nodeBtws,
+                                  std::vector<double> &clss,
+                                  std::vector<double> &frns,
+                                  std::vector<double> &linkBtws,
+                                  double *diam = NULL, int numThreads = 1);
+  static void CalcCentralitiesDijkstra(const CsrGraph &g, bool activeOnly,
+                                       std::vector<double> &nodeBtws,
+                                       std::vector<double> &clss,
+                                       std::vector<double> &frns,
+                                       std::vector<double> &linkBtws,
+                                       double *diam = NULL,
+                                       int numThreads = 1);
+
+  // same as CalcTopClssBFS and CalcTopFrnsBFS above, top is set to node
+  // indices and clss or frns to their centralities
+  static void CalcTopClssBFS(const CsrGraph &g, bool activeOnly, int k,
+                             std::vector<int> &top,
+                             std::vector<double> &clss);
+  static void CalcTopFrnsBFS(const CsrGraph &g, bool activeOnly, int k,
+                             std::vector<int> &top,
+                             std::vector<double> &frns);
+
+  // same as ApproxBetweennessBFS above, nodeBtws is indexed by the node,
+  // linkBtws by the link snapshot index
+  static double ApproxBetweennessBFS(const CsrGraph &g, bool activeOnly,
+                                     double eps, double delta,
+                                     std::vector<double> &nodeBtws,
+                                     std::vector<double> &linkBtws,
+                                     int *samples = NULL);
+
+  // compIds is set to component IDs ordered by decreasing component size
+  // (-1 for inactive nodes), compSizes to the component sizes
+  // returns the size of the largest component or -1 if there are none
+  static int AssignUComponentIDs(const CsrGraph &g, bool activeOnly,
+                                 std::vector<int> &compIds,
+                                 std::vector<int> &compSizes);
+
+  // builds a snapshot of an array of nodes with the nodes indexed by their
+  // positions in the array, links to nodes not in the array are left out
+  // and the other links are indexed in the order they are met among
+  // the out-links
+  static void BuildCsr(Node * const *nodes, int count, CsrGraph &ret);
+  // wrapper function for the previous one
+  static void BuildCsr(const PNodeVector &nodes, CsrGraph &ret);
 };
 
 #endif // ALG_HEADER_FILE_INCLUDED
@@ -0,0 +1,267 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+#include "Graphs/libgraphs.h"
+#include "Graphs/node.h"
+#include "Graphs/ptrmap.h"
+#include "Graphs/diropt.h"
+#include "Graphs/dheap.h"
+
+#ifndef ALGCONTEXT_HEADER_FILE_INCLUDED
+#define ALGCONTEXT_HEADER_FILE_INCLUDED
+
+/*
+  Working state of the Alg routines accepting a context
+  A context is bound to an array of nodes and stores the algorithms' state
+  in dense arrays indexed by a node's position in that array, so that
+  the routines do not modify the nodes and several of them may run
+  concurrently on the same graph with separate contexts
+  A context may be reused across calls while the bound nodes and the lengths
+  of their links do not change
+*/
+class LIBGRAPHS_API AlgContext
+{
+  PNodeVector m_nodes;
+  // positions of the bound nodes by their IDs, left empty when every node
+  // is bound at the position equal to its ID
+  std::vector<int> m_ixs;
+  // positions of the bound nodes by their addresses, used only when the
+  // nodes' IDs are not unique, e.g. the nodes come from several graphs
+  PtrHashMap<const Node *, int> m_ptrIxs;
+  bool m_byPtr;
+  // common length of the links between the bound nodes, -1 if the lengths
+  // differ, valid if m_lengthKnown is true
+  double m_length;
+  bool m_lengthKnown;
+  // numbers of the out- and in-links of the bound nodes when they were
+  // bound, used to choose the direction of BFS steps
+  double m_numLinks;
+  double m_numInLinks;
+
+  // traversal stamps, a node is reached by the current traversal if its
+  // stamp equals m_stamp
+  std::vector<unsigned> m_stamps;
+  unsigned m_stamp;
+
+public:
+  // distances from (or to) the source node, -1 if not reachable
+  std::vector<double> m_dist;
+  // indices of immediate incoming link nodes on shortest paths, -1 if none
+  std::vector<int> m_prev;
+  // visit marks
+  std::vector<int> m_mark;
+  // component IDs, -1 for nodes not assigned to a component
+  std::vector<int> m_comp;
+  // component sizes indexed by the component ID
+  std::vector<int> m_compSizes;
+  // indices of the nodes reached by the current traversal in the order
+  // they are reached, the first m_reached entries are valid
+  std::vector<int> m_queue;
+  int m_reached;
+  // frontier of a direction-optimizing BFS
+  FrontierBitmap m_front;
+  // nodes labelled but not settled yet by Dijkstra's algorithm, keyed by
+  // their distances
+  DHeap m_heap;
+
+  AlgContext()
+    : m_byPtr(false), m_length(-1), m_lengthKnown(false), m_numLinks(0),
+      m_numInLinks(0), m_stamp(0), m_reached(0)
+  {
+  }
+
+  AlgContext(Node * const *nodes, int count)
+    : m_byPtr(false), m_length(-1), m_lengthKnown(false), m_numLinks(0),
+      m_numInLinks(0), m_stamp(0), m_reached(0)
+  {
+    bind(nodes, count);
+  }
+
+  AlgContext(const PNodeVector &nodes)
+    : m_byPtr(false), m_length(-1), m_lengthKnown(false), m_numLinks(0),
+      m_numInLinks(0), m_stamp(0), m_reached(0)
+  {
+    bind(nodes);
+  }
+
+  void bind(Node * const *nodes, int count)
+  {
+    m_nodes.assign(nodes, nodes + count);
+    m_ixs.clear();
+    m_ptrIxs.clear();
+    m_byPtr = false;
+    m_lengthKnown = false;
+    m_stamps.clear();
+    m_stamp = 0;
+    m_reached = 0;
+    m_numLinks = m_numInLinks = 0;
+
+    int idBound = 0;
+    bool identity = true;
+    for (int i = 0; i < count; i++)
+    {
+      m_numLinks += nodes[i]->numLinks();
+      m_numInLinks += nodes[i]->numInLinks();
+      const int id = nodes[i]->m_id;
+      if (id != i)
+        identity = false;
+      if (id >= idBound)
+        idBound = id + 1;
+    }
+    if (identity)
+      return;
+
+    m_ixs.assign(idBound, -1);
+    for (int i = 0; i < count && !m_byPtr; i++)
+    {
+      const int id = nodes[i]->m_id;
+      if (id < 0 || m_ixs[id] >= 0)
+        m_byPtr = true;
+      else
+        m_ixs[id] = i;
+    }
+    if (!m_byPtr)
+      return;
+
+    m_ixs.clear();
+    m_ptrIxs.reserve(count);
+    for (int i = 0; i < count; i++)
+      m_ptrIxs.insert(nodes[i], i);
+  }
+
+  inline void bind(const PNodeVector &nodes)
+  {
+    bind(nodes.data(), (int)nodes.size());
+  }
+
+  inline int count() const { return (int)m_nodes.size(); }
+  inline Node *node(int i) const { return m_nodes[i]; }
+  inline const PNodeVector &nodes() const { return m_nodes; }
+
+  // returns the index of n in the bound array or -1 if n is not bound
+  inline int index(const Node *n) const
+  {
+    if (m_byPtr)
+    {
+      const int *ret = m_ptrIxs.find(n);
+      return ret != NULL ? *ret : -1;
+    }
+    const int id = n->m_id;
+    if (m_ixs.empty())
+      return (unsigned)id < m_nodes.size() && m_nodes[id] == n ? id : -1;
+    const int ix = (unsigned)id < m_ixs.size() ? m_ixs[id] : -1;
+    return ix >= 0 && m_nodes[ix] == n ? ix : -1;
+  }
+
+  // returns the common length of the links between the bound nodes or -1
+  // if the lengths differ, the result is cached until the next bind
+  double uniformLength()
+  {
+    if (m_lengthKnown)
+      return m_length;
+    m_lengthKnown = true;
+    m_length = -1;
+    bool first = true;
+    const int count = this->count();
+    for (int i = 0; i < count; i++)
+    {
+      const LinkVector &links = m_nodes[i]->links();
+      for (size_t j = 0; j < links.size(); j++)
+      {
+        if (index(links[j].n) < 0)
+          continue;
+        if (first)
+          m_length = links[j].d->m_length;
+        else if (links[j].d->m_length != m_length)
+          return m_length = -1;
+        first = false;
+      }
+    }
+    return m_length;
+  }
+
+  inline double numLinks() const { return m_numLinks; }
+  inline double numInLinks() const { return m_numInLinks; }
+
+  // starts a traversal which has not reached any node yet, takes O(1)
+  // time except for the first traversal after bind
+  void startTraversal()
+  {
+    const int count = this->count();
+    if ((int)m_stamps.size() != count || ++m_stamp == 0)
+    {
+      m_stamps.assign(count, 0);
+      m_stamp = 1;
+    }
+    m_dist.resize(count);
+    m_prev.resize(count);
+    m_queue.resize(count);
+    m_reached = 0;
+    if (m_heap.count() != count)
+      m_heap.reset(count);
+    else
+      m_heap.clear();
+  }
+
+  inline bool reached(int i) const { return m_stamps[i] == m_stamp; }
+
+  // returns true if node i is reached or waits in m_heap, i.e. m_dist and
+  // m_prev are set for it by the current traversal
+  inline bool labelled(int i) const
+  {
+    return m_stamps[i] == m_stamp || m_heap.contains(i);
+  }
+
+  // marks node i reached and appends it to m_queue
+  inline void reach(int i)
+  {
+    m_stamps[i] = m_stamp;
+    m_queue[m_reached++] = i;
+  }
+
+  // marks the first count nodes listed in m_queue reached, used when
+  // m_queue is filled without calls to reach
+  void setReached(int count)
+  {
+    for (int i = 0; i < count; i++)
+      m_stamps[m_queue[i]] = m_stamp;
+    m_reached = count;
+  }
+
+  inline Node *prev(int i) const
+  {
+    return m_prev[i] >= 0 ? m_nodes[m_prev[i]] : NULL;
+  }
+
+  // copies m_dist to m_dtag and m_prev to m_ntag of the bound nodes
+  void storeDistances() const
+  {
+    const int count = this->count();
+    for (int i = 0; i < count; i++)
+    {
+      m_nodes[i]->m_dtag = m_dist[i];
+      m_nodes[i]->m_ntag = prev(i);
+    }
+  }
+
+  // copies m_comp and m_compSizes to m_compId and m_compSize of the bound
+  // nodes
+  void storeComponents() const
+  {
+    const int count = this->count();
+    for (int i = 0; i < count; i++)
+    {
+      Node *n = m_nodes[i];
+      n->m_compId = m_comp[i];
+      if (m_comp[i] >= 0)
+        n->m_compSize = m_compSizes[m_comp[i]];
+    }
+  }
+};
+
+#endif // ALGCONTEXT_HEADER_FILE_INCLUDED
@@ -0,0 +1,1489 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include "stdafx.h"
+#include "Graphs/alg.h"
+#include "Graphs/parallel.h"
+#include "Graphs/diropt.h"
+#ifdef _MSC_VER
+#  include <intrin.h>
+#endif
+
+
+// selects the out- or in-link arrays of a snapshot
+struct CsrAdjacency
+{
+  const int *offsets;
+  const int *nodes;
+  const int *linkIxs;
+  const double *lengths;
+  const int *linkDactTimes;
+  const int *nodeDactTimes;
+
+  CsrAdjacency(const CsrGraph &g, bool forward)
+  {
+    offsets = forward ? &g.m_offsets[0] : &g.m_inOffsets[0];
+    nodes = forward ? g.m_targets.data() : g.m_inSources.data();
+    linkIxs = forward ? g.m_linkIxs.data() : g.m_inLinkIxs.data();
+    lengths = forward ? g.m_lengths.data() : g.m_inLengths.data();
+    linkDactTimes = forward ? g.m_linkDactTimes.data() :
+                              g.m_inLinkDactTimes.data();
+    nodeDactTimes = g.m_nodeDactTimes.data();
+  }
+
+  inline bool skip(int j, bool activeOnly) const
+  {
+    return activeOnly && (linkDactTimes[j] >= 0 ||
+                          nodeDactTimes[nodes[j]] >= 0);
+  }
+};
+
+// direction-optimizing BFS from src following the out-links of adj,
+// rev must select the opposite links; bottom-up steps are taken only when
+// all links have equal positive lengths
+// queue must have room for all nodes of the snapshot,
+// returns the number of reached nodes which are stored in the visit order
+// at the head of queue
+static int sg_CsrBFS(const CsrGraph &g, const CsrAdjacency &adj,
+                     const CsrAdjacency &rev, int src, bool activeOnly,
+                     double *dist, int *prev, int *queue)
+{
+  const int nc = g.nCount();
+  for (int i = 0; i < nc; i++)
+    dist[i] = -1;
+
+  if (activeOnly && adj.nodeDactTimes[src] >= 0)
+    return 0;
+
+  dist[src] = 0;
+  prev[src] = -1;
+
+  const bool canBottomUp = g.m_uniformLength > 0;
+  DirOptPolicy policy;
+  FrontierBitmap front;
+  double unvisitedLinks = rev.offsets[nc] - rev.offsets[src + 1] +
+                          rev.offsets[src];
+
+  int head = 0, tail = 0;
+  queue[tail++] = src;
+  while (head < tail)
+  {
+    const int levelEnd = tail;
+    bool bottomUp = false;
+    if (canBottomUp)
+    {
+      double frontierLinks = 0;
+      for (int k = head; k < levelEnd; k++)
+        frontierLinks += adj.offsets[queue[k] + 1] - adj.offsets[queue[k]];
+      bottomUp = policy.bottomUp(levelEnd - head, frontierLinks,
+                                 unvisitedLinks, nc);
+    }
+
+    if (bottomUp)
+    {
+      if (front.empty())
+        front.reset(nc);
+      for (int k = head; k < levelEnd; k++)
+        front.set(queue[k]);
+      for (int n2 = 0; n2 < nc; n2++)
+      {
+        if (dist[n2] >= 0 || (activeOnly && adj.nodeDactTimes[n2] >= 0))
+          continue;
+        const int jEnd = rev.offsets[n2 + 1];
+        for (int j = rev.offsets[n2]; j < jEnd; j++)
+        {
+          int n = rev.nodes[j];
+          if (!front.test(n) || rev.skip(j, activeOnly))
+            continue;
+          dist[n2] = dist[n] + rev.lengths[j];
+          prev[n2] = n;
+          queue[tail++] = n2;
+          break;
+        }
+      }
+      for (; head < levelEnd; head++)
+        front.unset(queue[head]);
+    }
+    else
+      for (; head < levelEnd; head++)
+      {
+        int n = queue[head];
+        double curd = dist[n];
+
+        const int jEnd = adj.offsets[n + 1];
+        for (int j = adj.offsets[n]; j < jEnd; j++)
+        {
+          if (adj.skip(j, activeOnly))
+            continue;
+          int n2 = adj.nodes[j];
+          double d2 = curd + adj.lengths[j];
+          if (dist[n2] < 0)
+          {
+            dist[n2] = d2;
+            prev[n2] = n;
+            queue[tail++] = n2;
+          }
+          else if (dist[n2] > d2)
+            throw Exception("Unsupported link lengths detected in a BFS "
+                            "paths calculation");
+        }
+      }
+
+    for (int k = levelEnd; k < tail; k++)
+      unvisitedLinks -= rev.offsets[queue[k] + 1] - rev.offsets[queue[k]];
+  }
+  return tail;
+}
+
+void Alg::CalcDistancesBFS(const CsrGraph &g, int src, bool activeOnly,
+                           bool forward, std::vector<double> &dist,
+                           std::vector<int> &prev)
+{
+  const int nc = g.nCount();
+  dist.resize(nc);
+  prev.assign(nc, -1);
+
+  std::vector<int> queue(nc);
+  CsrAdjacency adj(g, forward), rev(g, !forward);
+  sg_CsrBFS(g, adj, rev, src, activeOnly, &dist[0], &prev[0], &queue[0]);
+}
+
+
+// returns the index of the lowest set bit of a nonzero word
+static inline int sg_LowestBit(uint64_t w)
+{
+#ifdef _MSC_VER
+  unsigned long ret;
+  _BitScanForward64(&ret, w);
+  return (int)ret;
+#else
+  return __builtin_ctzll(w);
+#endif
+}
+
+void Alg::CalcDistanceSumsBFS(const CsrGraph &g, const std::vector<int> &srcs,
+                              bool activeOnly, bool forward,
+                              std::vector<double> &sums,
+                              std::vector<double> &invSums,
+                              std::vector<int> &reached)
+{
+  const int nc = g.nCount();
+  const int sc = (int)srcs.size();
+  sums.assign(sc, 0);
+  invSums.assign(sc, 0);
+  reached.assign(sc, 0);
+
+  CsrAdjacency adj(g, forward);
+  const double len = g.m_uniformLength;
+  if (len <= 0)
+  {
+    // a BFS per source which checks the link lengths
+    std::vector<double> dist(nc);
+    std::vector<int> prev(nc), queue(nc);
+    CsrAdjacency rev(g, !forward);
+    for (int b = 0; b < sc; b++)
+    {
+      reached[b] = sg_CsrBFS(g, adj, rev, srcs[b], activeOnly, &dist[0],
+                             &prev[0], &queue[0]);
+      for (int k = 1; k < reached[b]; k++)
+      {
+        const double d = dist[queue[k]];
+        sums[b] += d;
+        if (d > 0)
+          invSums[b] += 1.0 / d;
+      }
+    }
+    return;
+  }
+
+  // bit b of the masks of a node stands for the source first + b
+  std::vector<uint64_t> seen(nc), visit(nc), next(nc, 0);
+  int levelCounts[64];
+  for (int first = 0; first < sc; first += 64)
+  {
+    const int bc = std::min(64, sc - first);
+    std::fill(seen.begin(), seen.end(), 0);
+    std::fill(visit.begin(), visit.end(), 0);
+    for (int b = 0; b < bc; b++)
+    {
+      const int src = srcs[first + b];
+      if (activeOnly && adj.nodeDactTimes[src] >= 0)
+        continue;
+      seen[src] |= (uint64_t)1 << b;
+      visit[src] |= (uint64_t)1 << b;
+      reached[first + b] = 1;
+    }
+
+    bool any = true;
+    for (int level = 1; any; level++)
+    {
+      // a single scan of the links of the frontier nodes advances all
+      // the sources whose frontiers include them
+      for (int n = 0; n < nc; n++)
+      {
+        const uint64_t v = visit[n];
+        if (v == 0)
+          continue;
+        const int jEnd = adj.offsets[n + 1];
+        for (int j = adj.offsets[n]; j < jEnd; j++)
+          if (!adj.skip(j, activeOnly))
+            next[adj.nodes[j]] |= v;
+      }
+
+      any = false;
+      std::fill(levelCounts, levelCounts + bc, 0);
+      for (int n = 0; n < nc; n++)
+      {
+        uint64_t v = next[n] & ~seen[n];
+        next[n] = 0;
+        visit[n] = v;
+        if (v == 0)
+          continue;
+        any = true;
+        seen[n] |= v;
+        for (; v != 0; v &= v - 1)
+          levelCounts[sg_LowestBit(v)]++;
+      }
+
+      const double d = level * len;
+      for (int b = 0; b < bc; b++)
+      {
+        sums[first + b] += levelCounts[b] * d;
+        invSums[first + b] += levelCounts[b] / d;
+        reached[first + b] += levelCounts[b];
+      }
+    }
+  }
+}
+
+
+struct PQItemCsrDijkstra
+{
+  int node;
+  double value;
+  bool operator< (const PQItemCsrDijkstra &v) const
+  {
+    return value > v.value;
+  }
+};
+
+void Alg::RunDijkstra(const CsrGraph &g, int src, bool activeOnly,
+                      bool forward, std::vector<double> &dist,
+                      std::vector<int> &prev)
+{
+  const int nc = g.nCount();
+  dist.assign(nc, -1);
+  prev.assign(nc, -1);
+
+  CsrAdjacency adj(g, forward);
+  if (activeOnly && adj.nodeDactTimes[src] >= 0)
+    return;
+
+  DHeap heap;
+  heap.reset(nc);
+
+  dist[src] = 0;
+  heap.push(src, 0);
+
+  while (!heap.empty())
+  {
+    const int n = heap.pop();
+    const double curd = dist[n];
+
+    const int jEnd = adj.offsets[n + 1];
+    for (int j = adj.offsets[n]; j < jEnd; j++)
+    {
+      if (adj.skip(j, activeOnly))
+        continue;
+
+      int n2 = adj.nodes[j];
+      double d2 = curd + adj.lengths[j];
+      if (dist[n2] < 0)
+        heap.push(n2, d2);
+      else if (d2 < dist[n2] && heap.contains(n2))
+        heap.decrease(n2, d2);
+      else
+        continue;
+      dist[n2] = d2;
+      prev[n2] = n;
+    }
+  }
+}
+
+
+// largest number of buckets kept by each thread of a delta-stepping search
+static const int sg_MAX_DELTA_BUCKETS = 1 << 16;
+
+// returns the bucket width of a delta-stepping search, the mean length of
+// the followed links divided by their mean number per node, so that
+// a bucket's light links reach few nodes of the same bucket again, sets
+// maxLength to the largest link length; throws an exception if a link of
+// a negative length is detected
+static double sg_DeltaSteppingDelta(const CsrAdjacency &adj, int nc,
+                                    bool activeOnly, double &maxLength)
+{
+  double sum = 0;
+  int count = 0;
+  maxLength = 0;
+  for (int i = 0; i < nc; i++)
+  {
+    if (activeOnly && adj.nodeDactTimes[i] >= 0)
+      continue;
+    for (int j = adj.offsets[i]; j < adj.offsets[i + 1]; j++)
+    {
+      if (adj.skip(j, activeOnly))
+        continue;
+      const double len = adj.lengths[j];
+      if (len < 0)
+        throw Exception("Negative link lengths are not supported by "
+                        "delta-stepping");
+      sum += len;
+      count++;
+      if (len > maxLength)
+        maxLength = len;
+    }
+  }
+  if (sum <= 0)
+    return 1;
+  return sum / count / std::max(1.0, (double)count / nc);
+}
+
+// request to relax a link from parent to node made by one thread of
+// a delta-stepping search to the thread owning the node
+struct DeltaRequest
+{
+  int node;
+  int parent;
+  double dist;
+};
+
+// delta-stepping search (Meyer and Sanders): the nodes are kept in buckets
+// of tentative distances of width delta which are emptied in the order of
+// increasing distances; links no longer than delta (light links) of
+// a bucket's nodes are relaxed in rounds until the bucket stays empty,
+// the longer (heavy) ones once for all nodes removed from the bucket
+// Node i is owned by thread i % numThreads, which alone updates its
+// distance and its bucket; the other threads send it relaxation requests
+// processed in the thread order between barriers, so that no atomic
+// updates are needed and the distances do not depend on the number of
+// threads; the buckets are cyclic as the tentative distances never exceed
+// the current bucket's by more than the largest link length
+class DeltaSteppingTask : public IParallelTask
+{
+  const CsrAdjacency &m_adj;
+  const CsrAdjacency &m_rev;
+  const int m_nc;
+  const int m_src;
+  const bool m_activeOnly;
+  const double m_delta;
+  const int m_numBuckets;
+  std::vector<double> &m_dist;
+  std::vector<int> &m_prev;
+
+  // distances of the nodes when their links were relaxed last
+  std::vector<double> m_relaxed;
+  // cyclic buckets of each thread
+  std::vector<std::vector<std::vector<int> > > m_buckets;
+  // requests from thread t to thread s are in m_requests[t][s]
+  std::vector<std::vector<std::vector<DeltaRequest> > > m_requests;
+  // per-thread smallest nonempty bucket and nonempty current bucket flags
+  std::vector<long long> m_next;
+  std::vector<char> m_busy;
+  Barrier m_barrier;
+
+  inline long long bucket(double d) const
+  {
+    return (long long)(d / m_delta);
+  }
+
+  void request(int thread, int numThreads, int v, bool light)
+  {
+    const double d = m_dist[v];
+    std::vector<std::vector<DeltaRequest> > &requests = m_requests[thread];
+    for (int j = m_adj.offsets[v]; j < m_adj.offsets[v + 1]; j++)
+    {
+      if (m_adj.skip(j, m_activeOnly) ||
+          (m_adj.lengths[j] <= m_delta) != light)
+        continue;
+      DeltaRequest req = { m_adj.nodes[j], v, d + m_adj.lengths[j] };
+      requests[req.node % numThreads].push_back(req);
+    }
+  }
+
+  void relax(int thread, int numThreads)
+  {
+    std::vector<std::vector<int> > &buckets = m_buckets[thread];
+    for (int t = 0; t < numThreads; t++)
+    {
+      std::vector<DeltaRequest> &requests = m_requests[t][thread];
+      for (size_t k = 0; k < requests.size(); k++)
+      {
+        const DeltaRequest &req = requests[k];
+        if (req.dist < m_dist[req.node])
+        {
+          m_dist[req.node] = req.dist;
+          m_prev[req.node] = req.parent;
+          buckets[bucket(req.dist) % m_numBuckets].push_back(req.node);
+        }
+      }
+      requests.clear();
+    }
+  }
+
+public:
+  DeltaSteppingTask(const CsrAdjacency &adj, const CsrAdjacency &rev,
+                    int nc, int src, bool activeOnly, double delta,
+                    int numBuckets, int numThreads, std::vector<double> &dist,
+                    std::vector<int> &prev)
+    : m_adj(adj), m_rev(rev), m_nc(nc), m_src(src),
+      m_activeOnly(activeOnly), m_delta(delta), m_numBuckets(numBuckets),
+      m_dist(dist), m_prev(prev), m_relaxed(nc),
+      m_buckets(numThreads, std::vector<std::vector<int> >(numBuckets)),
+      m_requests(numThreads,
+                 std::vector<std::vector<DeltaRequest> >(numThreads)),
+      m_next(numThreads), m_busy(numThreads), m_barrier(numThreads)
+  {
+  }
+
+  virtual void run(int thread, int numThreads)
+  {
+    const int beg = (int)((long long)m_nc * thread / numThreads);
+    const int end = (int)((long long)m_nc * (thread + 1) / numThreads);
+    for (int i = beg; i < end; i++)
+    {
+      m_dist[i] = Alg::INF;
+      m_prev[i] = -1;
+      m_relaxed[i] = Alg::INF;
+    }
+    if (!m_barrier.wait())
+      return;
+    std::vector<std::vector<int> > &buckets = m_buckets[thread];
+    if (m_src % numThreads == thread)
+    {
+      m_dist[m_src] = 0;
+      buckets[0].push_back(m_src);
+    }
+    if (!m_barrier.wait())
+      return;
+
+    std::vector<int> front, removed;
+    long long cur = 0;
+    for (;;)
+    {
+      m_next[thread] = LLONG_MAX;
+      for (long long b = cur; b < cur + m_numBuckets; b++)
+        if (!buckets[b % m_numBuckets].empty())
+        {
+          m_next[thread] = b;
+          break;
+        }
+      if (!m_barrier.wait())
+        return;
+      cur = LLONG_MAX;
+      for (int t = 0; t < numThreads; t++)
+        cur = std::min(cur, m_next[t]);
+      if (cur == LLONG_MAX)
+        break;
+
+      // light links in rounds, a node is relaxed again only if its
+      // distance decreased since it was relaxed last
+      removed.clear();
+      for (;;)
+      {
+        front.clear();
+        front.swap(buckets[cur % m_numBuckets]);
+        for (size_t k = 0; k < front.size(); k++)
+        {
+          const int v = front[k];
+          const double d = m_dist[v];
+          if (bucket(d) != cur || m_relaxed[v] == d)
+            continue;
+          if (m_relaxed[v] == Alg::INF || bucket(m_relaxed[v]) != cur)
+            removed.push_back(v);
+          m_relaxed[v] = d;
+          request(thread, numThreads, v, true);
+        }
+        if (!m_barrier.wait())
+          return;
+        relax(thread, numThreads);
+        m_busy[thread] = !buckets[cur % m_numBuckets].empty();
+        if (!m_barrier.wait())
+          return;
+        bool busy = false;
+        for (int t = 0; t < numThreads; t++)
+          busy = busy || m_busy[t];
+        if (!busy)
+          break;
+      }
+
+      // heavy links lead to later buckets
+      for (size_t k = 0; k < removed.size(); k++)
+        request(thread, numThreads, removed[k], false);
+      if (!m_barrier.wait())
+        return;
+      relax(thread, numThreads);
+    }
+
+    // a node's parent is the node of the smallest index among those
+    // of smaller distances linked to it by a link on a shortest path, or
+    // the node it was reached from if there are none (zero-length links),
+    // so that the parents too do not depend on the number of threads
+    // in all but the latter case
+    for (int v = beg; v < end; v++)
+    {
+      const double d = m_dist[v];
+      if (v == m_src || d == Alg::INF)
+        continue;
+      int best = INT_MAX;
+      for (int j = m_rev.offsets[v]; j < m_rev.offsets[v + 1]; j++)
+      {
+        const int u = m_rev.nodes[j];
+        if (u < best && !m_rev.skip(j, m_activeOnly) && m_dist[u] < d &&
+            m_dist[u] + m_rev.lengths[j] == d)
+          best = u;
+      }
+      if (best != INT_MAX)
+        m_prev[v] = best;
+    }
+    if (!m_barrier.wait())
+      return;
+    for (int v = beg; v < end; v++)
+      if (m_dist[v] == Alg::INF)
+        m_dist[v] = -1;
+  }
+
+  virtual void cancel()
+  {
+    m_barrier.cancel();
+  }
+};
+
+void Alg::RunDeltaStepping(const CsrGraph &g, int src, bool activeOnly,
+                           bool forward, std::vector<double> &dist,
+                           std::vector<int> &prev, int numThreads,
+                           double delta)
+{
+  const int nc = g.nCount();
+  CsrAdjacency adj(g, forward), rev(g, !forward);
+  if (activeOnly && adj.nodeDactTimes[src] >= 0)
+  {
+    dist.assign(nc, -1);
+    prev.assign(nc, -1);
+    return;
+  }
+  dist.resize(nc);
+  prev.resize(nc);
+
+  double maxLength;
+  const double autoDelta = sg_DeltaSteppingDelta(adj, nc, activeOnly,
+                                                 maxLength);
+  if (delta <= 0)
+    delta = autoDelta;
+  // a few very long links should not make the buckets too many
+  delta = std::max(delta, maxLength / (sg_MAX_DELTA_BUCKETS - 3));
+  const int numBuckets = (int)(maxLength / delta) + 3;
+
+  numThreads = Parallel::NumThreads(numThreads);
+  DeltaSteppingTask task(adj, rev, nc, src, activeOnly, delta, numBuckets,
+                         numThreads, dist, prev);
+  Parallel::Run(task, numThreads);
+}
+
+
+// working arrays of the path counting traversals of one thread,
+// dist and sigma are valid for the nodes reached by the current traversal
+struct CsrTraversal
+{
+  std::vector<double> dist;
+  std::vector<double> sigma;
+  std::vector<int> queue;
+  std::vector<unsigned> stamps;
+  unsigned stamp;
+  std::vector<PQItemCsrDijkstra> heap;
+
+  CsrTraversal(int nc)
+    : dist(nc), sigma(nc), queue(nc), stamps(nc, 0), stamp(0)
+  {
+  }
+
+  // starts a traversal which has not reached any node yet
+  void start()
+  {
+    if (++stamp == 0)
+    {
+      stamps.assign(stamps.size(), 0);
+      stamp = 1;
+    }
+  }
+
+  inline bool reached(int i) const { return stamps[i] == stamp; }
+
+  inline void reach(int i, double d)
+  {
+    stamps[i] = stamp;
+    dist[i] = d;
+    sigma[i] = 0;
+  }
+};
+
+// BFS from src which counts shortest paths in sigma, returns the number of
+// reached nodes which are stored in the visit order at the head of queue
+static int sg_CsrCountPathsBFS(const CsrAdjacency &adj, int src,
+                               bool activeOnly, CsrTraversal &t)
+{
+  double *dist = t.dist.data();
+  double *sigma = t.sigma.data();
+  int *queue = t.queue.data();
+
+  t.start();
+  t.reach(src, 0);
+  sigma[src] = 1;
+  int head = 0, tail = 0;
+  queue[tail++] = src;
+  while (head < tail)
+  {
+    int n = queue[head++];
+    double curd = dist[n];
+
+    const int jEnd = adj.offsets[n + 1];
+    for (int j = adj.offsets[n]; j < jEnd; j++)
+    {
+      if (adj.skip(j, activeOnly))
+        continue;
+      int n2 = adj.nodes[j];
+      double d2 = curd + adj.lengths[j];
+      if (!t.reached(n2))
+      {
+        t.reach(n2, d2);
+        queue[tail++] = n2;
+      }
+      else if (dist[n2] > d2)
+        throw Exception("Unsupported link lengths detected in a BFS paths "
+                        "calculation");
+      if (dist[n2] == d2)
+        sigma[n2] += sigma[n];
+    }
+  }
+  return tail;
+}
+
+// Dijkstra's algorithm from src which counts shortest paths in sigma,
+// returns the number of reached nodes which are stored in the order of
+// nondecreasing distances at the head of queue
+static int sg_CsrCountPathsDijkstra(const CsrAdjacency &adj, int src,
+                                    bool activeOnly, CsrTraversal &t)
+{
+  double *dist = t.dist.data();
+  double *sigma = t.sigma.data();
+  int *queue = t.queue.data();
+  std::vector<PQItemCsrDijkstra> &heap = t.heap;
+
+  t.start();
+  t.reach(src, 0);
+  sigma[src] = 1;
+  heap.clear();
+  PQItemCsrDijkstra item = { src, 0 };
+  heap.push_back(item);
+
+  int tail = 0;
+  while (heap.size() > 0)
+  {
+    std::pop_heap(heap.begin(), heap.end());
+    PQItemCsrDijkstra top = heap.back();
+    heap.pop_back();
+    if (dist[top.node] < top.value)
+      continue;
+    int n = top.node;
+    queue[tail++] = n;
+
+    const int jEnd = adj.offsets[n + 1];
+    for (int j = adj.offsets[n]; j < jEnd; j++)
+    {
+      if (adj.skip(j, activeOnly))
+        continue;
+      // the path counts of a node are final once it leaves the heap only
+      // if all its shortest paths are made of positive length links
+      if (adj.lengths[j] <= 0)
+        throw Exception("Unsupported link lengths detected in a Dijkstra "
+                        "paths calculation");
+      int n2 = adj.nodes[j];
+      double d2 = top.value + adj.lengths[j];
+      if (!t.reached(n2) || d2 < dist[n2])
+      {
+        t.reach(n2, d2);
+        sigma[n2] = sigma[n];
+        PQItemCsrDijkstra nItem = { n2, d2 };
+        heap.push_back(nItem);
+        std::push_heap(heap.begin(), heap.end());
+      }
+      else if (dist[n2] == d2)
+        sigma[n2] += sigma[n];
+    }
+  }
+  return tail;
+}
+
+// number of source chunks in a centralities calculation, the chunks do not
+// depend on the number of threads so that the sums are always added up in
+// the same order
+static const int sg_CENTRALITY_CHUNKS = 256;
+
+// Brandes' algorithm on the reversed graph run by a group of threads,
+// shortest paths are counted with a BFS or, if weighted is true, with
+// Dijkstra's algorithm
+// Sources are split into chunks, in each round thread t accumulates
+// betweenness for the next chunk but t in its own arrays, then the threads
+// add the arrays to the results in the chunk order, each thread over its
+// own slice of nodes and links
+class CsrCentralitiesTask : public IParallelTask
+{
+  const CsrAdjacency m_adj;
+  const int m_nc;
+  const int m_lc;
+  const bool m_activeOnly;
+  const bool m_weighted;
+  const int m_chunk;
+  const int m_numChunks;
+
+  std::vector<double> &m_nodeBtws;
+  std::vector<double> &m_clss;
+  std::vector<double> &m_frns;
+  std::vector<double> &m_linkBtws;
+
+  // betweenness of the nodes followed by that of the links per thread
+  std::vector<std::vector<double> > m_accs;
+  std::vector<double> m_diams;
+  Barrier m_barrier;
+
+  void processSource(int cur, double *acc, CsrTraversal &t, double *delta,
+                     double &d)
+  {
+    const CsrAdjacency &adj = m_adj;
+    int reached = m_weighted ?
+      sg_CsrCountPathsDijkstra(adj, cur, m_activeOnly, t) :
+      sg_CsrCountPathsBFS(adj, cur, m_activeOnly, t);
+    const double *dist = t.dist.data();
+    const double *sigma = t.sigma.data();
+    const int *queue = t.queue.data();
+
+    // skip cur itself which is the first node in the queue
+    double clss = 0, frns = 0;
+    for (int k = 1; k < reached; k++)
+    {
+      int src = queue[k];
+      if (dist[src] > d)
+        d = dist[src];
+      clss += 1.0 / dist[src];
+      frns += dist[src];
+    }
+    m_clss[cur] = clss / m_nc;
+    m_frns[cur] = frns / reached;
+
+    double *linkAcc = acc + m_nc;
+    for (int k = reached - 1; k >= 0; k--)
+    {
+      int w = queue[k];
+      const int jEnd = adj.offsets[w + 1];
+      for (int j = adj.offsets[w]; j < jEnd; j++)
+      {
+        if (adj.skip(j, m_activeOnly))
+          continue;
+        int x = adj.nodes[j];
+        if (dist[x] != dist[w] + adj.lengths[j])
+          continue;
+        double c = sigma[w] / sigma[x] * (1 + delta[x]);
+        linkAcc[adj.linkIxs[j]] += c;
+        delta[w] += c;
+      }
+      if (w != cur)
+        acc[w] += delta[w];
+    }
+    for (int k = 0; k < reached; k++)
+      delta[queue[k]] = 0;
+  }
+
+public:
+  CsrCentralitiesTask(const CsrGraph &g, bool activeOnly, bool weighted,
+                      int numThreads, std::vector<double> &nodeBtws,
+                      std::vector<double> &clss, std::vector<double> &frns,
+                      std::vector<double> &linkBtws)
+    : m_adj(g, false), m_nc(g.nCount()), m_lc(g.ldCount()),
+      m_activeOnly(activeOnly), m_weighted(weighted),
+      m_chunk((g.nCount() + sg_CENTRALITY_CHUNKS - 1) / sg_CENTRALITY_CHUNKS),
+      m_numChunks(m_chunk > 0 ? (g.nCount() + m_chunk - 1) / m_chunk : 0),
+      m_nodeBtws(nodeBtws), m_clss(clss), m_frns(frns), m_linkBtws(linkBtws),
+      m_accs(numThreads, std::vector<double>(g.nCount() + g.ldCount(), 0)),
+      m_diams(numThreads, 0), m_barrier(numThreads)
+  {
+  }
+
+  double diameter() const
+  {
+    double ret = 0;
+    for (size_t i = 0; i < m_diams.size(); i++)
+      if (m_diams[i] > ret)
+        ret = m_diams[i];
+    return ret;
+  }
+
+  virtual void run(int thread, int numThreads)
+  {
+    CsrTraversal t(m_nc);
+    std::vector<double> delta(m_nc, 0);
+    double *acc = m_accs[thread].data();
+    const int *nDact = m_adj.nodeDactTimes;
+
+    // the slice of nodes and links merged by this thread
+    const int total = m_nc + m_lc;
+    const int sliceBeg = (int)((long long)total * thread / numThreads);
+    const int sliceEnd = (int)((long long)total * (thread + 1) / numThreads);
+
+    double d = 0;
+    for (int first = 0; first < m_numChunks; first += numThreads)
+    {
+      const int chunk = first + thread;
+      if (chunk < m_numChunks)
+      {
+        const int curEnd = std::min(m_nc, (chunk + 1) * m_chunk);
+        for (int cur = chunk * m_chunk; cur < curEnd; cur++)
+          if (!m_activeOnly || nDact[cur] < 0)
+            processSource(cur, acc, t, &delta[0], d);
+      }
+      if (!m_barrier.wait())
+        return;
+
+      const int used = std::min(numThreads, m_numChunks - first);
+      for (int t = 0; t < used; t++)
+      {
+        double *tAcc = m_accs[t].data();
+        for (int i = sliceBeg; i < sliceEnd; i++)
+        {
+          if (i < m_nc)
+            m_nodeBtws[i] += tAcc[i];
+          else
+            m_linkBtws[i - m_nc] += tAcc[i];
+          tAcc[i] = 0;
+        }
+      }
+      if (!m_barrier.wait())
+        return;
+    }
+    m_diams[thread] = d;
+  }
+
+  virtual void cancel()
+  {
+    m_barrier.cancel();
+  }
+};
+
+static void sg_CsrCalcCentralities(const CsrGraph &g, bool activeOnly,
+                                   bool weighted,
+                                   std::vector<double> &nodeBtws,
+                                   std::vector<double> &clss,
+                                   std::vector<double> &frns,
+                                   std::vector<double> &linkBtws,
+                                   double *diam, int numThreads)
+{
+  const int nc = g.nCount();
+  const int lc = g.ldCount();
+  const std::vector<int> &nDact = g.m_nodeDactTimes;
+
+  nodeBtws.assign(nc, 0);
+  clss.assign(nc, 0);
+  frns.assign(nc, 0);
+  linkBtws.assign(lc, 0);
+
+  // inactive nodes, inactive links, and links incident on inactive nodes
+  // get -1 centralities
+  if (activeOnly)
+    for (int i = 0; i < nc; i++)
+    {
+      if (nDact[i] >= 0)
+        nodeBtws[i] = clss[i] = frns[i] = -1;
+      for (int j = g.m_offsets[i]; j < g.m_offsets[i + 1]; j++)
+        if (nDact[i] >= 0 || nDact[g.m_targets[j]] >= 0 ||
+            g.m_linkDactTimes[j] >= 0)
+          linkBtws[g.m_linkIxs[j]] = -1;
+    }
+
+  // there is no use in more threads than chunks of sources
+  numThreads = Parallel::NumThreads(numThreads);
+  const int maxThreads = std::min(nc, sg_CENTRALITY_CHUNKS);
+  if (numThreads > maxThreads)
+    numThreads = maxThreads > 0 ? maxThreads : 1;
+
+  CsrCentralitiesTask task(g, activeOnly, weighted, numThreads, nodeBtws,
+                           clss, frns, linkBtws);
+  Parallel::Run(task, numThreads);
+  if (diam != NULL)
+    *diam = task.diameter();
+}
+
+void Alg::CalcCentralitiesBFS(const CsrGraph &g, bool activeOnly,
+                              std::vector<double> &nodeBtws,
+                              std::vector<double> &clss,
+                              std::vector<double> &frns,
+                              std::vector<double> &linkBtws,
+                              double *diam, int numThreads)
+{
+  sg_CsrCalcCentralities(g, activeOnly, false, nodeBtws, clss, frns,
+                         linkBtws, diam, numThreads);
+}
+
+void Alg::CalcCentralitiesDijkstra(const CsrGraph &g, bool activeOnly,
+                                   std::vector<double> &nodeBtws,
+                                   std::vector<double> &clss,
+                                   std::vector<double> &frns,
+                                   std::vector<double> &linkBtws,
+                                   double *diam, int numThreads)
+{
+  sg_CsrCalcCentralities(g, activeOnly, true, nodeBtws, clss, frns,
+                         linkBtws, diam, numThreads);
+}
+
+
+// BFS from src over the links of adj which stops at the end of a level
+// once the key of src provably falls below cutoff, the key being the sum
+// of the inverse distances to the reached nodes, or the negated sum of
+// the distances if farness is true; the nodes not reached yet, at most
+// count less the reached ones, are at least one level farther than
+// the last level and only the nodes adjacent to the last level may be
+// exactly one level farther (Bergamini et al.); levels are only cut when
+// all links have the equal positive length len
+// returns the number of reached nodes and stores the key in key, or
+// returns -1 if the BFS is cut
+static int sg_CsrCutBFS(const CsrAdjacency &adj, double len, int src,
+                        bool activeOnly, bool farness, int count,
+                        double cutoff, CsrTraversal &t, double &key)
+{
+  double *dist = t.dist.data();
+  int *queue = t.queue.data();
+
+  t.start();
+  t.reach(src, 0);
+  int head = 0, tail = 0;
+  queue[tail++] = src;
+  double sum = 0;
+  while (head < tail)
+  {
+    const int levelEnd = tail;
+    double frontierLinks = 0;
+    for (; head < levelEnd; head++)
+    {
+      int n = queue[head];
+      double curd = dist[n];
+
+      const int jEnd = adj.offsets[n + 1];
+      for (int j = adj.offsets[n]; j < jEnd; j++)
+      {
+        if (adj.skip(j, activeOnly))
+          continue;
+        int n2 = adj.nodes[j];
+        double d2 = curd + adj.lengths[j];
+        if (!t.reached(n2))
+        {
+          t.reach(n2, d2);
+          queue[tail++] = n2;
+          sum += farness ? d2 : 1 / d2;
+          frontierLinks += adj.offsets[n2 + 1] - adj.offsets[n2];
+        }
+        else if (dist[n2] > d2)
+          throw Exception("Unsupported link lengths detected in a BFS "
+                          "paths calculation");
+      }
+    }
+    if (len <= 0 || tail == levelEnd)
+      continue;
+
+    const double d = dist[queue[tail - 1]];
+    const double rest = count - tail;
+    const double next = std::min(frontierLinks, rest);
+    const double bound = farness ?
+      -(sum + next * (d + len) + (rest - next) * (d + 2 * len)) :
+      sum + next / (d + len) + (rest - next) / (d + 2 * len);
+    if (bound < cutoff)
+      return -1;
+  }
+  key = farness ? -sum : sum;
+  return tail;
+}
+
+static void sg_CsrTopCentralities(const CsrGraph &g, bool activeOnly, int k,
+                                  bool farness, std::vector<int> &top,
+                                  std::vector<double> &values)
+{
+  const int nc = g.nCount();
+  const std::vector<int> &nDact = g.m_nodeDactTimes;
+  CsrAdjacency adj(g, false);
+
+  // the candidates in the order of decreasing in-degrees, which tend to
+  // find central nodes early and raise the cutoff, by index among equal
+  // in-degrees
+  std::vector<std::pair<int, int> > order;
+  for (int i = 0; i < nc; i++)
+    if (!activeOnly || nDact[i] < 0)
+      order.push_back(std::make_pair(adj.offsets[i] - adj.offsets[i + 1],
+                                     i));
+  std::sort(order.begin(), order.end());
+  const int count = (int)order.size();
+
+  // the best k nodes so far as pairs of the negated keys and the indices,
+  // the worst one at the top of the heap
+  std::vector<std::pair<double, int> > heap;
+  CsrTraversal t(nc);
+  for (int i = 0; i < count && k > 0; i++)
+  {
+    const int cur = order[i].second;
+    const double cutoff = (int)heap.size() == k ? -heap.front().first :
+                                                  -Alg::INF;
+    double key;
+    const int reached = sg_CsrCutBFS(adj, g.m_uniformLength, cur,
+                                     activeOnly, farness, count, cutoff, t,
+                                     key);
+    if (reached < 0)
+      continue;
+    if (farness && reached < count)
+      throw Exception("The graph is not strongly connected");
+
+    const std::pair<double, int> item(-key, cur);
+    if ((int)heap.size() < k)
+    {
+      heap.push_back(item);
+      std::push_heap(heap.begin(), heap.end());
+    }
+    else if (item < heap.front())
+    {
+      std::pop_heap(heap.begin(), heap.end());
+      heap.back() = item;
+      std::push_heap(heap.begin(), heap.end());
+    }
+  }
+
+  std::sort_heap(heap.begin(), heap.end());
+  top.resize(heap.size());
+  values.resize(heap.size());
+  for (size_t i = 0; i < heap.size(); i++)
+  {
+    top[i] = heap[i].second;
+    values[i] = farness ? heap[i].first / count : -heap[i].first / nc;
+  }
+}
+
+void Alg::CalcTopClssBFS(const CsrGraph &g, bool activeOnly, int k,
+                         std::vector<int> &top, std::vector<double> &clss)
+{
+  sg_CsrTopCentralities(g, activeOnly, k, false, top, clss);
+}
+
+void Alg::CalcTopFrnsBFS(const CsrGraph &g, bool activeOnly, int k,
+                         std::vector<int> &top, std::vector<double> &frns)
+{
+  sg_CsrTopCentralities(g, activeOnly, k, true, top, frns);
+}
+
+
+// returns a random integer from 0 to count - 1, two draws are combined so
+// that large counts are covered where RAND_MAX is small
+static int sg_RandIndex(int count)
+{
+  double u = RAND_0_1;
+  u += RAND_0_1 / ((double)RAND_MAX + 1);
+  int ret = (int)(count * u);
+  return ret < count ? ret : count - 1;
+}
+
+// returns true if every link is met among the out-links of both its ends
+// as is the case for undirected graphs
+static bool sg_CsrIsSymmetric(const CsrGraph &g)
+{
+  std::vector<int> counts(g.ldCount(), 0);
+  for (size_t j = 0; j < g.m_linkIxs.size(); j++)
+    counts[g.m_linkIxs[j]]++;
+  for (size_t i = 0; i < counts.size(); i++)
+    if (counts[i] != 2)
+      return false;
+  return true;
+}
+
+// returns an upper bound on the number of nodes on a shortest path,
+// in undirected graphs the bound is 2 * e + 1 where e is the eccentricity
+// (in hops) of a node of the component, in directed graphs it is
+// the size of the largest weakly connected component
+static int sg_CsrVertexDiameterBound(const CsrGraph &g, bool activeOnly)
+{
+  const int nc = g.nCount();
+  const bool symmetric = sg_CsrIsSymmetric(g);
+  CsrAdjacency adjs[2] = { CsrAdjacency(g, true), CsrAdjacency(g, false) };
+  const int adjCount = symmetric ? 1 : 2;
+
+  std::vector<int> hops(nc, -1);
+  std::vector<int> queue(nc);
+  int ret = 0;
+  for (int i = 0; i < nc; i++)
+  {
+    if (hops[i] >= 0 || (activeOnly && g.m_nodeDactTimes[i] >= 0))
+      continue;
+
+    int head = 0, tail = 0;
+    queue[tail++] = i;
+    hops[i] = 0;
+    while (head < tail)
+    {
+      int n = queue[head++];
+      for (int a = 0; a < adjCount; a++)
+      {
+        const CsrAdjacency &adj = adjs[a];
+        const int jEnd = adj.offsets[n + 1];
+        for (int j = adj.offsets[n]; j < jEnd; j++)
+        {
+          if (adj.skip(j, activeOnly))
+            continue;
+          int n2 = adj.nodes[j];
+          if (hops[n2] < 0)
+          {
+            hops[n2] = hops[n] + 1;
+            queue[tail++] = n2;
+          }
+        }
+      }
+    }
+
+    int bound = tail;
+    if (symmetric && 2 * hops[queue[tail - 1]] + 1 < bound)
+      bound = 2 * hops[queue[tail - 1]] + 1;
+    if (bound > ret)
+      ret = bound;
+  }
+  return ret;
+}
+
+// working state of the shortest path sampling, the arrays are valid
+// for the nodes stamped with the current sample number
+struct CsrPathSampler
+{
+  CsrAdjacency fwd;
+  CsrAdjacency bwd;
+  const int nc;
+  const bool activeOnly;
+
+  std::vector<unsigned> stamps;
+  unsigned stamp;
+  std::vector<double> dist;
+  std::vector<double> sigma;
+  std::vector<int> queue;
+
+  CsrPathSampler(const CsrGraph &g, bool activeOnly)
+    : fwd(g, true), bwd(g, false), nc(g.nCount()), activeOnly(activeOnly),
+      stamps(g.nCount(), 0), stamp(0), dist(g.nCount()),
+      sigma(g.nCount()), queue(g.nCount())
+  {
+  }
+
+  // picks a shortest path from src to dst uniformly at random and
+  // increments the counts of its inner nodes and of its links,
+  // does nothing if dst is not reachable from src
+  void sample(int src, int dst, int *nodeCounts, int *linkCounts)
+  {
+    if (++stamp == 0)
+    {
+      stamps.assign(nc, 0);
+      stamp = 1;
+    }
+
+    // BFS from src counting shortest paths, stops once the level before
+    // the one of dst is done so that sigma[dst] is final
+    stamps[src] = stamp;
+    dist[src] = 0;
+    sigma[src] = 1;
+    bool found = false;
+    int head = 0, tail = 0;
+    queue[tail++] = src;
+    while (head < tail)
+    {
+      int n = queue[head++];
+      double curd = dist[n];
+      if (found && curd >= dist[dst])
+        break;
+
+      const int jEnd = fwd.offsets[n + 1];
+      for (int j = fwd.offsets[n]; j < jEnd; j++)
+      {
+        if (fwd.skip(j, activeOnly))
+          continue;
+        int n2 = fwd.nodes[j];
+        double d2 = curd + fwd.lengths[j];
+        if (stamps[n2] != stamp)
+        {
+          stamps[n2] = stamp;
+          dist[n2] = d2;
+          sigma[n2] = 0;
+          queue[tail++] = n2;
+          if (n2 == dst)
+            found = true;
+        }
+        else if (dist[n2] > d2)
+          throw Exception("Unsupported link lengths detected in a BFS paths "
+                          "calculation");
+        if (dist[n2] == d2)
+          sigma[n2] += sigma[n];
+      }
+    }
+    if (!found)
+      return;
+
+    // walk back from dst choosing each predecessor with the probability
+    // proportional to the number of shortest paths through it
+    int w = dst;
+    while (w != src)
+    {
+      double r = RAND_0_1 * sigma[w];
+      int x = -1, lix = -1;
+      const int jEnd = bwd.offsets[w + 1];
+      for (int j = bwd.offsets[w]; j < jEnd; j++)
+      {
+        if (bwd.skip(j, activeOnly))
+          continue;
+        int n2 = bwd.nodes[j];
+        if (stamps[n2] != stamp || dist[n2] + bwd.lengths[j] != dist[w])
+          continue;
+        x = n2;
+        lix = bwd.linkIxs[j];
+        r -= sigma[n2];
+        if (r < 0)
+          break;
+      }
+      linkCounts[lix]++;
+      if (x != src)
+        nodeCounts[x]++;
+      w = x;
+    }
+  }
+};
+
+// returns the empirical Bernstein bound on the deviation of the frequency
+// of count successes in r Bernoulli trials from their probability,
+// logTerm is the logarithm of 2 / delta
+static double sg_BernsteinBound(int count, int r, double logTerm)
+{
+  double p = (double)count / r;
+  double var = p * (1 - p) * r / (r - 1);
+  return sqrt(2 * var * logTerm / r) + 7 * logTerm / (3 * (r - 1));
+}
+
+double Alg::ApproxBetweennessBFS(const CsrGraph &g, bool activeOnly,
+                                 double eps, double delta,
+                                 std::vector<double> &nodeBtws,
+                                 std::vector<double> &linkBtws,
+                                 int *samples)
+{
+  if (eps <= 0 || eps >= 1 || delta <= 0 || delta >= 1)
+    throw Exception("Both epsilon and delta must be in the (0, 1) range");
+
+  const int nc = g.nCount();
+  const int lc = g.ldCount();
+  const std::vector<int> &nDact = g.m_nodeDactTimes;
+
+  nodeBtws.assign(nc, 0);
+  linkBtws.assign(lc, 0);
+  if (samples != NULL)
+    *samples = 0;
+
+  // inactive nodes, inactive links, and links incident on inactive nodes
+  // get -1 centralities
+  std::vector<int> active;
+  active.reserve(nc);
+  for (int i = 0; i < nc; i++)
+  {
+    if (activeOnly && nDact[i] >= 0)
+      nodeBtws[i] = -1;
+    else
+      active.push_back(i);
+    if (activeOnly)
+      for (int j = g.m_offsets[i]; j < g.m_offsets[i + 1]; j++)
+        if (nDact[i] >= 0 || nDact[g.m_targets[j]] >= 0 ||
+            g.m_linkDactTimes[j] >= 0)
+          linkBtws[g.m_linkIxs[j]] = -1;
+  }
+  const int n = (int)active.size();
+  if (n < 2)
+    return 0;
+
+  // the sample size of Riondato and Kornaropoulos which guarantees the
+  // bound eps with the probability 1 - delta / 2 for all nodes and links,
+  // a path with vd nodes has vd - 1 links
+  const int vd = sg_CsrVertexDiameterBound(g, activeOnly);
+  const double vcDim = vd > 2 ? floor(log2((double)(vd - 1))) + 1 : 1;
+  const double rMax = ceil(0.5 / (eps * eps) * (vcDim + log(2 / delta)));
+  if (rMax > INT_MAX)
+    throw Exception("Too many samples are needed to achieve the bound");
+
+  // samples are drawn in stages doubling the sample size, the sampling
+  // stops once the Bernstein bounds on all estimates reach eps with
+  // the probability 1 - delta / 2 shared by the stages
+  int stages = 1;
+  while (stages < 30 && rMax / (1 << stages) >= 100)
+    stages++;
+  const int elements = n + lc;
+  const double logTerm = log(4.0 * stages * elements / delta);
+
+  CsrPathSampler sampler(g, activeOnly);
+  std::vector<int> nodeCounts(nc, 0);
+  std::vector<int> linkCounts(lc, 0);
+  int r = 0;
+  double achieved = 1;
+  for (int stage = stages - 1; stage >= 0; stage--)
+  {
+    const int rStage = (int)ceil(rMax / (1 << stage));
+    for (; r < rStage; r++)
+    {
+      int src = sg_RandIndex(n);
+      int dst = sg_RandIndex(n - 1);
+      if (dst >= src)
+        dst++;
+      sampler.sample(active[src], active[dst], nodeCounts.data(),
+                     linkCounts.data());
+    }
+
+    // the bound grows with the count for frequencies up to 1 / 2
+    const int half = r / 2;
+    int maxCount = 0;
+    for (int i = 0; i < nc; i++)
+      if (nodeCounts[i] > maxCount)
+        maxCount = std::min(nodeCounts[i], half);
+    for (int i = 0; i < lc; i++)
+      if (linkCounts[i] > maxCount)
+        maxCount = std::min(linkCounts[i], half);
+    achieved = r > 1 ? sg_BernsteinBound(maxCount, r, logTerm) : 1;
+    if (stage == 0 && achieved > eps)
+      achieved = eps;
+    if (achieved <= eps)
+      break;
+  }
+
+  // the frequencies estimate the betweenness normalized on the number of
+  // ordered pairs of nodes
+  const double scale = (double)n * (n - 1) / r;
+  for (int i = 0; i < nc; i++)
+    if (nodeBtws[i] >= 0)
+      nodeBtws[i] = nodeCounts[i] * scale;
+  for (int i = 0; i < lc; i++)
+    if (linkBtws[i] >= 0)
+      linkBtws[i] = linkCounts[i] * scale;
+  if (samples != NULL)
+    *samples = r;
+  return achieved;
+}
+
+
+void Alg::BuildCsr(Node * const *nodes, int count, CsrGraph &ret)
+{
+  // links are numbered in the order they are first met among the out-links
+  AlgContext ctx(nodes, count);
+  PtrHashMap<const LinkData *, int> linkIxs;
+
+  ret.clear();
+  ret.m_nodes.assign(nodes, nodes + count);
+  ret.m_nodeDactTimes.resize(count);
+  ret.m_offsets.resize(count + 1);
+  ret.m_inOffsets.resize(count + 1);
+
+  for (int i = 0; i < count; i++)
+  {
+    ret.m_nodeDactTimes[i] = nodes[i]->m_dactTime;
+
+    ret.m_offsets[i] = (int)ret.m_targets.size();
+    const LinkVector &links = nodes[i]->links();
+    for (size_t j = 0; j < links.size(); j++)
+    {
+      const int n2 = ctx.index(links[j].n);
+      if (n2 < 0)
+        continue;
+      LinkData *ld = links[j].d;
+      const int lix = *linkIxs.insert(ld, (int)ret.m_links.size());
+      if (lix == (int)ret.m_links.size())
+        ret.m_links.push_back(ld);
+      ret.m_targets.push_back(n2);
+      ret.m_linkIxs.push_back(lix);
+      ret.m_lengths.push_back(ld->m_length);
+      ret.m_weights.push_back(ld->m_weight);
+      ret.m_linkDactTimes.push_back(ld->m_dactTime);
+    }
+  }
+  ret.m_offsets[count] = (int)ret.m_targets.size();
+
+  for (int i = 0; i < count; i++)
+  {
+    ret.m_inOffsets[i] = (int)ret.m_inSources.size();
+    const LinkVector &inLinks = nodes[i]->inLinks();
+    for (size_t j = 0; j < inLinks.size(); j++)
+    {
+      const int n2 = ctx.index(inLinks[j].n);
+      if (n2 < 0)
+        continue;
+      const LinkData *ld = inLinks[j].d;
+      const int *lix = linkIxs.find(ld);
+      if (lix == NULL)
+        continue;
+      ret.m_inSources.push_back(n2);
+      ret.m_inLinkIxs.push_back(*lix);
+      ret.m_inLengths.push_back(ld->m_length);
+      ret.m_inWeights.push_back(ld->m_weight);
+      ret.m_inLinkDactTimes.push_back(ld->m_dactTime);
+    }
+  }
+  ret.m_inOffsets[count] = (int)ret.m_inSources.size();
+  ret.findUniformLength();
+}
+
+void Alg::BuildCsr(const PNodeVector &nodes, CsrGraph &ret)
+{
+  BuildCsr(nodes.data(), (int)nodes.size(), ret);
+}
+
+
+int Alg::AssignUComponentIDs(const CsrGraph &g, bool activeOnly,
+                             std::vector<int> &compIds,
+                             std::vector<int> &compSizes)
+{
+  const int nc = g.nCount();
+  compIds.assign(nc, -1);
+  compSizes.clear();
+
+  // components are numbered in the discovery order first
+  std::vector<int> queue(nc);
+  CsrAdjacency adj(g, true);
+  for (int i = 0; i < nc; i++)
+  {
+    if (compIds[i] >= 0 || (activeOnly && adj.nodeDactTimes[i] >= 0))
+      continue;
+
+    const int cid = (int)compSizes.size();
+    int head = 0, tail = 0;
+    queue[tail++] = i;
+    compIds[i] = cid;
+    while (head < tail)
+    {
+      int n = queue[head++];
+      const int jEnd = adj.offsets[n + 1];
+      for (int j = adj.offsets[n]; j < jEnd; j++)
+      {
+        if (activeOnly && adj.linkDactTimes[j] >= 0)
+          continue;
+        int n2 = adj.nodes[j];
+        if (compIds[n2] < 0 && (!activeOnly || adj.nodeDactTimes[n2] < 0))
+        {
+          compIds[n2] = cid;
+          queue[tail++] = n2;
+        }
+      }
+    }
+    compSizes.push_back(tail);
+  }
+
+  return renumberComponents(compIds, compSizes);
+}
@@ -83,6 +83,7 @@ int BGraph::DeactDependent(int dactTime)
         ret++;
     }
   }
+  invalidateActivation();
 
   return ret;
 }
@@ -16,6 +16,14 @@ class LIBGRAPHS_API BGraph : public Graph
 protected:
   void linkAndDeleteFromTo(BNode **from, BNode **to, int count, int numLinks);
 
+  // the coupled graph's nodes are made to refer to the copies
+  virtual void compacting(const Graph &copy)
+  {
+    const int nc = nCount();
+    for (int i = 0; i < nc; i++)
+      ((BNode *)node(i))->redirectDep((BNode *)copy.node(i));
+  }
+
 public:
   BGraph() : Graph(new NetFactory<BNode, LinkData>())
   {
@@ -25,6 +33,21 @@ public:
   {
   }
 
+  // nodes of the copy depend on and control the same nodes of the coupled
+  // graph as the originals do, without being referred to by them
+  virtual Graph *clone() const
+  {
+    BGraph *ret = new BGraph();
+    copyTo(*ret);
+    return ret;
+  }
+
+  virtual void removeNode(Node *n)
+  {
+    ((BNode *)n)->clearDep();
+    Graph::removeNode(n);
+  }
+
   int DeactDependent(int dactTime);
 
   void ReadDependencyLinks(const char *path, BGraph &g, bool isMutual);
@@ -5,31 +5,48 @@
   See LICENSE file in the project root for full license information.
 */
 
+#include <new>
 #include "Utils/utils.h"
 
 #ifndef BLKMEM_HEADER_FILE
 #define BLKMEM_HEADER_FILE
 
+/*
+  Arena of objects allocated in fixed size blocks
+  Objects are constructed once, when they are handed out by next() for the
+  first time; resize() rewinds the arena without freeing memory or
+  destroying objects, so that next() hands the same objects out again and
+  the caller is responsible for reinitializing them
+  Blocks are freed only by the destructor
+*/
 template<typename T>
   class BlockMemMgr
   {
     size_t m_blkSize;
     size_t m_count;
+    // number of objects constructed so far, the objects are never destroyed
+    // before the arena is
+    size_t m_constructed;
+
+    T *newBlock()
+    {
+      return static_cast<T *>(::operator new(m_blkSize * sizeof(T)));
+    }
 
   public:
+    // size of a huge memory page on common platforms
+    enum { HUGE_PAGE_BYTES = 2 * 1024 * 1024 };
+
     std::vector<T *> m_blocks;
+
     T &next()
     {
-      if (m_count % m_blkSize == 0)
+      if (m_count == m_constructed)
       {
-        size_t nsz = m_count / m_blkSize + 1;
-        if (nsz > m_blocks.size())
-          m_blocks.push_back(new T[m_blkSize]);
-        else
-        {
-          delete [] m_blocks[nsz - 1];
-          m_blocks[nsz - 1] = new T[m_blkSize];
-        }
+        if (m_count / m_blkSize == m_blocks.size())
+          m_blocks.push_back(newBlock());
+        new (&(*this)[(int)m_count]) T();
+        m_constructed++;
       }
       T &ret = m_blocks[m_count / m_blkSize][m_count % m_blkSize];
       m_count++;
@@ -39,17 +56,58 @@ template<typename T>
     {
       return m_blocks[i / m_blkSize][i % m_blkSize];
     }
-    inline void resize(int count) { m_count = count; }
+    // rewinds the arena to count objects, throws an exception if count
+    // exceeds the number of objects handed out since the arena was created,
+    // as next() would then hand out memory holding no objects
+    void resize(int count)
+    {
+      if (count < 0 || (size_t)count > m_constructed)
+        throw Exception("Unable to resize a memory arena beyond the objects "
+                        "it has handed out");
+      m_count = count;
+    }
     inline size_t count() const { return m_count; }
+    inline size_t blockSize() const { return m_blkSize; }
+    inline size_t capacity() const { return m_blocks.size() * m_blkSize; }
+    // returns the number of bytes allocated by the arena for objects
+    inline size_t memoryUsage() const { return capacity() * sizeof(T); }
+
+    // allocates blocks for count objects so that next() does not allocate
+    // memory until count objects are handed out
+    void reserve(size_t count)
+    {
+      while (capacity() < count)
+        m_blocks.push_back(newBlock());
+    }
+
+    // changes the number of objects in a block, may be called only before
+    // any memory is allocated
+    void setBlockSize(size_t blkSize)
+    {
+      if (m_blocks.size() > 0)
+        throw Exception("Unable to change the block size of an arena in use");
+      m_blkSize = blkSize > 0 ? blkSize : 1;
+    }
+
+    // makes each block occupy a whole number of huge pages, large blocks
+    // are mapped directly by the system allocator so that they may be
+    // backed by transparent huge pages
+    void setHugePageBlocks(size_t pages = 1)
+    {
+      setBlockSize(pages * HUGE_PAGE_BYTES / sizeof(T));
+    }
 
-    BlockMemMgr(size_t blkSize = 1024) : m_count(0), m_blkSize(blkSize)
+    BlockMemMgr(size_t blkSize = 1024)
+      : m_blkSize(blkSize > 0 ? blkSize : 1), m_count(0), m_constructed(0)
     {
     }
 
     virtual ~BlockMemMgr()
     {
+      for (size_t i = 0; i < m_constructed; i++)
+        (*this)[(int)i].~T();
       for (size_t i = 0; i < m_blocks.size(); i++)
-        delete [] m_blocks[i];
+        ::operator delete(m_blocks[i]);
     }
   };
 
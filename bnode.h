@@ -23,6 +23,12 @@ public:
     m_dep = m_ctrl = NULL;
   }
 
+  virtual void reinit()
+  {
+    Node::reinit();
+    m_dep = m_ctrl = NULL;
+  }
+
   inline BNode *ctrl() const { return m_ctrl; }
   inline BNode *dep() const { return m_dep; }
 
@@ -32,6 +38,25 @@ public:
     n2->m_ctrl = this;
   }
 
+  // makes the nodes this node depends on and controls refer to n instead
+  void redirectDep(BNode *n)
+  {
+    if (m_dep != NULL && m_dep->m_ctrl == this)
+      m_dep->m_ctrl = n;
+    if (m_ctrl != NULL && m_ctrl->m_dep == this)
+      m_ctrl->m_dep = n;
+  }
+
+  // detaches the node from the nodes it depends on and controls
+  void clearDep()
+  {
+    if (m_dep != NULL && m_dep->m_ctrl == this)
+      m_dep->m_ctrl = NULL;
+    if (m_ctrl != NULL && m_ctrl->m_dep == this)
+      m_ctrl->m_dep = NULL;
+    m_dep = m_ctrl = NULL;
+  }
+
   inline bool controlOk()
   {
     return m_ctrl == NULL || m_ctrl->m_dactTime < 0;
@@ -0,0 +1,706 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include "stdafx.h"
+#include "Graphs/chier.h"
+#include "Graphs/alg.h"
+
+
+// link of the graph being contracted
+struct CHArc
+{
+  int node;
+  double length;
+  int middle;
+};
+
+typedef std::vector<CHArc> CHArcVector;
+
+struct CHShortcut
+{
+  int from;
+  int to;
+  double length;
+};
+
+// link of a path being unpacked
+struct CHSpan
+{
+  int from;
+  int to;
+  int middle;
+};
+
+// packs the links of the nodes into arrays indexed by offsets
+static void sg_Flatten(const std::vector<CHArcVector> &arcs,
+                       std::vector<int> &offsets, std::vector<int> &nodes,
+                       std::vector<double> &lengths,
+                       std::vector<int> &middles)
+{
+  offsets.resize(arcs.size() + 1);
+  nodes.clear();
+  lengths.clear();
+  middles.clear();
+  for (size_t i = 0; i < arcs.size(); i++)
+  {
+    offsets[i] = (int)nodes.size();
+    for (size_t j = 0; j < arcs[i].size(); j++)
+    {
+      nodes.push_back(arcs[i][j].node);
+      lengths.push_back(arcs[i][j].length);
+      middles.push_back(arcs[i][j].middle);
+    }
+  }
+  offsets[arcs.size()] = (int)nodes.size();
+}
+
+/*
+  Contracts the nodes of a graph in the order of their priorities, which
+  are kept up to date lazily: a node taken from the heap is contracted only
+  if its recalculated priority still does not exceed the smallest one
+  A node's priority is twice the number of shortcuts its contraction adds
+  less the number of its links, plus the number of its contracted
+  neighbors and its level, which spread the contraction evenly over
+  the graph and keep the upward paths short
+*/
+class CHBuilder
+{
+  const int m_nc;
+  // links between the nodes not contracted yet
+  std::vector<CHArcVector> m_out;
+  std::vector<CHArcVector> m_in;
+  std::vector<int> m_contractedNbrs;
+  // levels of the nodes, one more than the highest level of their
+  // contracted neighbors
+  std::vector<int> m_levels;
+
+  // state of the witness searches, valid for the nodes whose stamps equal
+  // m_stamp
+  std::vector<double> m_dist;
+  std::vector<unsigned> m_stamps;
+  unsigned m_stamp;
+  DHeap m_heap;
+  // marks the ends of the links of the node being contracted
+  std::vector<char> m_targets;
+
+  std::vector<CHShortcut> m_shortcuts;
+
+  // adds a link from u to w or shortens the existing one
+  void addLink(int u, int w, double length, int middle)
+  {
+    CHArcVector &out = m_out[u];
+    size_t j = 0;
+    while (j < out.size() && out[j].node != w)
+      j++;
+    if (j == out.size())
+    {
+      CHArc arc = { w, length, middle };
+      out.push_back(arc);
+      arc.node = u;
+      m_in[w].push_back(arc);
+      return;
+    }
+    if (out[j].length <= length)
+      return;
+    out[j].length = length;
+    out[j].middle = middle;
+    CHArcVector &in = m_in[w];
+    for (size_t k = 0; k < in.size(); k++)
+      if (in[k].node == u)
+      {
+        in[k].length = length;
+        in[k].middle = middle;
+        break;
+      }
+  }
+
+  static void removeLink(CHArcVector &arcs, int node)
+  {
+    for (size_t j = 0; j < arcs.size(); j++)
+      if (arcs[j].node == node)
+      {
+        arcs[j] = arcs.back();
+        arcs.pop_back();
+        return;
+      }
+  }
+
+  // Dijkstra's algorithm from src avoiding the node skip which stops once
+  // the distances exceed bound, the target nodes marked in m_targets are
+  // settled, or limit nodes are settled
+  void witnessSearch(int src, int skip, double bound, int targets, int limit)
+  {
+    if (++m_stamp == 0)
+    {
+      m_stamps.assign(m_nc, 0);
+      m_stamp = 1;
+    }
+    m_heap.clear();
+    m_stamps[src] = m_stamp;
+    m_dist[src] = 0;
+    m_heap.push(src, 0);
+
+    int settled = 0;
+    while (!m_heap.empty() && m_heap.topKey() <= bound && targets > 0 &&
+           settled < limit)
+    {
+      const int u = m_heap.pop();
+      settled++;
+      if (m_targets[u])
+        targets--;
+      const CHArcVector &out = m_out[u];
+      for (size_t j = 0; j < out.size(); j++)
+      {
+        const int w = out[j].node;
+        if (w == skip)
+          continue;
+        const double d = m_dist[u] + out[j].length;
+        if (m_stamps[w] != m_stamp)
+        {
+          m_stamps[w] = m_stamp;
+          m_dist[w] = d;
+          m_heap.push(w, d);
+        }
+        else if (d < m_dist[w] && m_heap.contains(w))
+        {
+          m_dist[w] = d;
+          m_heap.decrease(w, d);
+        }
+      }
+    }
+  }
+
+  // stores in m_shortcuts the shortcuts the contraction of v needs,
+  // the paths through v without witness paths of the same length found
+  // settling at most limit nodes
+  void findShortcuts(int v, int limit)
+  {
+    m_shortcuts.clear();
+    const CHArcVector &in = m_in[v];
+    const CHArcVector &out = m_out[v];
+    double maxOut = 0;
+    for (size_t j = 0; j < out.size(); j++)
+    {
+      maxOut = std::max(maxOut, out[j].length);
+      m_targets[out[j].node] = 1;
+    }
+
+    for (size_t i = 0; i < in.size(); i++)
+    {
+      const int u = in[i].node;
+      witnessSearch(u, v, in[i].length + maxOut, (int)out.size(), limit);
+      for (size_t j = 0; j < out.size(); j++)
+      {
+        const int w = out[j].node;
+        if (w == u)
+          continue;
+        const double length = in[i].length + out[j].length;
+        if (m_stamps[w] == m_stamp && m_dist[w] <= length)
+          continue;
+        CHShortcut sc = { u, w, length };
+        m_shortcuts.push_back(sc);
+      }
+    }
+    for (size_t j = 0; j < out.size(); j++)
+      m_targets[out[j].node] = 0;
+  }
+
+  // estimates the priority with witness searches cut short, which may
+  // only overestimate the shortcuts
+  double priority(int v)
+  {
+    findShortcuts(v, ContractionHierarchy::ESTIMATE_SETTLE_LIMIT);
+    return 2 * ((double)m_shortcuts.size() -
+                (double)(m_in[v].size() + m_out[v].size())) +
+           m_contractedNbrs[v] + m_levels[v];
+  }
+
+public:
+  CHBuilder(const CsrGraph &g, bool activeOnly)
+    : m_nc(g.nCount()), m_out(m_nc), m_in(m_nc), m_contractedNbrs(m_nc, 0),
+      m_levels(m_nc, 0), m_dist(m_nc), m_stamps(m_nc, 0), m_stamp(0),
+      m_targets(m_nc, 0)
+  {
+    m_heap.reset(m_nc);
+    const std::vector<int> &nDact = g.m_nodeDactTimes;
+    for (int i = 0; i < m_nc; i++)
+    {
+      if (activeOnly && nDact[i] >= 0)
+        continue;
+      for (int j = g.m_offsets[i]; j < g.m_offsets[i + 1]; j++)
+      {
+        const int w = g.m_targets[j];
+        if (w == i || (activeOnly && (nDact[w] >= 0 ||
+                                      g.m_linkDactTimes[j] >= 0)))
+          continue;
+        if (g.m_lengths[j] < 0)
+          throw Exception("Negative link lengths are not supported in "
+                          "a contraction hierarchy");
+        addLink(i, w, g.m_lengths[j], -1);
+      }
+    }
+  }
+
+  void run(ContractionHierarchy &ch)
+  {
+    // links of the contracted nodes to the nodes contracted after them
+    std::vector<CHArcVector> up(m_nc), down(m_nc);
+    ch.m_ranks.assign(m_nc, -1);
+
+    DHeap order;
+    order.reset(m_nc);
+    for (int i = 0; i < m_nc; i++)
+      order.push(i, priority(i));
+
+    int rank = 0;
+    while (!order.empty())
+    {
+      const int v = order.pop();
+      const double p = priority(v);
+      if (!order.empty() && p > order.topKey())
+      {
+        order.push(v, p);
+        continue;
+      }
+
+      findShortcuts(v, ContractionHierarchy::WITNESS_SETTLE_LIMIT);
+      for (size_t k = 0; k < m_shortcuts.size(); k++)
+      {
+        const CHShortcut &sc = m_shortcuts[k];
+        addLink(sc.from, sc.to, sc.length, v);
+      }
+      ch.m_ranks[v] = rank++;
+      up[v].swap(m_out[v]);
+      down[v].swap(m_in[v]);
+      for (size_t j = 0; j < up[v].size(); j++)
+      {
+        const int w = up[v][j].node;
+        removeLink(m_in[w], v);
+        m_contractedNbrs[w]++;
+        m_levels[w] = std::max(m_levels[w], m_levels[v] + 1);
+      }
+      for (size_t j = 0; j < down[v].size(); j++)
+      {
+        const int u = down[v][j].node;
+        removeLink(m_out[u], v);
+        m_contractedNbrs[u]++;
+        m_levels[u] = std::max(m_levels[u], m_levels[v] + 1);
+      }
+    }
+
+    sg_Flatten(up, ch.m_upOffsets, ch.m_upNodes, ch.m_upLengths,
+               ch.m_upMiddles);
+    sg_Flatten(down, ch.m_downOffsets, ch.m_downNodes, ch.m_downLengths,
+               ch.m_downMiddles);
+  }
+};
+
+
+void ContractionHierarchy::clear()
+{
+  m_ranks.clear();
+  m_upOffsets.clear();
+  m_upNodes.clear();
+  m_upLengths.clear();
+  m_upMiddles.clear();
+  m_downOffsets.clear();
+  m_downNodes.clear();
+  m_downLengths.clear();
+  m_downMiddles.clear();
+}
+
+void ContractionHierarchy::build(const CsrGraph &g, bool activeOnly)
+{
+  clear();
+  CHBuilder builder(g, activeOnly);
+  builder.run(*this);
+}
+
+void ContractionHierarchy::build(const PNodeVector &nodes, bool activeOnly)
+{
+  CsrGraph g;
+  Alg::BuildCsr(nodes, g);
+  build(g, activeOnly);
+}
+
+
+static const char sg_CH_MAGIC[8] = { 'G', 'R', 'C', 'H', 'I', 'E', 'R', 1 };
+
+template<typename T>
+  static void sg_WriteVector(std::ostream &os, const std::vector<T> &v)
+  {
+    const int size = (int)v.size();
+    os.write((const char *)&size, sizeof(size));
+    if (size > 0)
+      os.write((const char *)&v[0], sizeof(T) * size);
+  }
+
+template<typename T>
+  static void sg_ReadVector(std::istream &is, std::vector<T> &v)
+  {
+    int size = -1;
+    is.read((char *)&size, sizeof(size));
+    if (!is.good() || size < 0)
+      throw Exception("Unable to read a contraction hierarchy");
+    v.resize(size);
+    if (size > 0)
+      is.read((char *)&v[0], sizeof(T) * size);
+  }
+
+void ContractionHierarchy::write(std::ostream &os) const
+{
+  os.write(sg_CH_MAGIC, sizeof(sg_CH_MAGIC));
+  sg_WriteVector(os, m_ranks);
+  sg_WriteVector(os, m_upOffsets);
+  sg_WriteVector(os, m_upNodes);
+  sg_WriteVector(os, m_upLengths);
+  sg_WriteVector(os, m_upMiddles);
+  sg_WriteVector(os, m_downOffsets);
+  sg_WriteVector(os, m_downNodes);
+  sg_WriteVector(os, m_downLengths);
+  sg_WriteVector(os, m_downMiddles);
+  if (!os.good())
+    throw Exception("Unable to write a contraction hierarchy");
+}
+
+void ContractionHierarchy::write(const char *path) const
+{
+  std::ofstream ofs(path, std::ios_base::out | std::ios_base::binary);
+  if (!ofs.good())
+    throw Exception("Unable to open the contraction hierarchy output file");
+  write(ofs);
+}
+
+void ContractionHierarchy::read(std::istream &is)
+{
+  clear();
+  char magic[sizeof(sg_CH_MAGIC)];
+  is.read(magic, sizeof(magic));
+  if (!is.good() || memcmp(magic, sg_CH_MAGIC, sizeof(magic)) != 0)
+    throw Exception("Unable to read a contraction hierarchy");
+  sg_ReadVector(is, m_ranks);
+  sg_ReadVector(is, m_upOffsets);
+  sg_ReadVector(is, m_upNodes);
+  sg_ReadVector(is, m_upLengths);
+  sg_ReadVector(is, m_upMiddles);
+  sg_ReadVector(is, m_downOffsets);
+  sg_ReadVector(is, m_downNodes);
+  sg_ReadVector(is, m_downLengths);
+  sg_ReadVector(is, m_downMiddles);
+
+  const size_t nc = m_ranks.size();
+  if (is.fail() || m_upOffsets.size() != nc + 1 ||
+      m_downOffsets.size() != nc + 1 ||
+      m_upOffsets[nc] != (int)m_upNodes.size() ||
+      m_downOffsets[nc] != (int)m_downNodes.size() ||
+      m_upLengths.size() != m_upNodes.size() ||
+      m_upMiddles.size() != m_upNodes.size() ||
+      m_downLengths.size() != m_downNodes.size() ||
+      m_downMiddles.size() != m_downNodes.size())
+  {
+    clear();
+    throw Exception("Unable to read a contraction hierarchy");
+  }
+}
+
+void ContractionHierarchy::read(const char *path)
+{
+  std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
+  if (!ifs.good())
+    throw Exception("Unable to open the contraction hierarchy input file");
+  read(ifs);
+}
+
+
+CHQuery::CHQuery(const ContractionHierarchy &ch) : m_ch(ch), m_stamp(0)
+{
+}
+
+void CHQuery::start()
+{
+  const int nc = m_ch.nCount();
+  if ((int)m_dist[0].size() != nc || ++m_stamp == 0)
+  {
+    for (int dir = 0; dir < 2; dir++)
+    {
+      m_dist[dir].resize(nc);
+      m_parents[dir].resize(nc);
+      m_parentLinks[dir].resize(nc);
+      m_stamps[dir].assign(nc, 0);
+      m_heaps[dir].reset(nc);
+    }
+    m_stamp = 1;
+  }
+  m_heaps[0].clear();
+  m_heaps[1].clear();
+}
+
+// labels node x of the search dir with the distance d through the link j
+// of node parent, returns false if x keeps a shorter distance
+static inline bool sg_Label(std::vector<double> &dist,
+                            std::vector<int> &parents,
+                            std::vector<int> &parentLinks,
+                            std::vector<unsigned> &stamps, unsigned stamp,
+                            DHeap &heap, int x, double d, int parent, int j)
+{
+  if (stamps[x] != stamp)
+  {
+    stamps[x] = stamp;
+    heap.push(x, d);
+  }
+  else if (d < dist[x] && heap.contains(x))
+    heap.decrease(x, d);
+  else
+    return false;
+  dist[x] = d;
+  parents[x] = parent;
+  parentLinks[x] = j;
+  return true;
+}
+
+// runs the upward search from src to exhaustion without stalling, which
+// leaves the exact upward distances of all reached nodes
+void CHQuery::upwardSearch(int dir, int src, double bound)
+{
+  const std::vector<int> &offsets = dir == 0 ? m_ch.m_upOffsets :
+                                               m_ch.m_downOffsets;
+  const std::vector<int> &nodes = dir == 0 ? m_ch.m_upNodes :
+                                             m_ch.m_downNodes;
+  const std::vector<double> &lengths = dir == 0 ? m_ch.m_upLengths :
+                                                  m_ch.m_downLengths;
+  DHeap &heap = m_heaps[dir];
+  sg_Label(m_dist[dir], m_parents[dir], m_parentLinks[dir], m_stamps[dir],
+           m_stamp, heap, src, 0, -1, -1);
+  while (!heap.empty() && heap.topKey() <= bound)
+  {
+    const int u = heap.pop();
+    for (int j = offsets[u]; j < offsets[u + 1]; j++)
+      sg_Label(m_dist[dir], m_parents[dir], m_parentLinks[dir],
+               m_stamps[dir], m_stamp, heap, nodes[j],
+               m_dist[dir][u] + lengths[j], u, j);
+  }
+}
+
+// appends to path the nodes of the link from the node from to the node
+// to, the shortcuts being unpacked, except the node from
+void CHQuery::appendLink(int from, int to, int middle,
+                         std::vector<int> &path) const
+{
+  const ContractionHierarchy &ch = m_ch;
+  std::vector<CHSpan> stack;
+  CHSpan span = { from, to, middle };
+  stack.push_back(span);
+  while (!stack.empty())
+  {
+    const CHSpan cur = stack.back();
+    stack.pop_back();
+    const int mid = cur.middle;
+    if (mid < 0)
+    {
+      path.push_back(cur.to);
+      continue;
+    }
+
+    // the halves of a shortcut are the links of the middle node, which is
+    // contracted before both ends
+    CHSpan first = { cur.from, mid, -1 };
+    CHSpan second = { mid, cur.to, -1 };
+    for (int j = ch.m_downOffsets[mid]; j < ch.m_downOffsets[mid + 1]; j++)
+      if (ch.m_downNodes[j] == cur.from)
+        first.middle = ch.m_downMiddles[j];
+    for (int j = ch.m_upOffsets[mid]; j < ch.m_upOffsets[mid + 1]; j++)
+      if (ch.m_upNodes[j] == cur.to)
+        second.middle = ch.m_upMiddles[j];
+    stack.push_back(second);
+    stack.push_back(first);
+  }
+}
+
+double CHQuery::distance(int src, int dst, std::vector<int> *path)
+{
+  const ContractionHierarchy &ch = m_ch;
+  start();
+  if (path != NULL)
+    path->clear();
+
+  sg_Label(m_dist[0], m_parents[0], m_parentLinks[0], m_stamps[0], m_stamp,
+           m_heaps[0], src, 0, -1, -1);
+  sg_Label(m_dist[1], m_parents[1], m_parentLinks[1], m_stamps[1], m_stamp,
+           m_heaps[1], dst, 0, -1, -1);
+  double best = Alg::INF;
+  int meet = -1;
+
+  for (;;)
+  {
+    // a search stops once its closest unsettled node is not closer than
+    // the shortest path found
+    for (int dir = 0; dir < 2; dir++)
+      if (!m_heaps[dir].empty() && m_heaps[dir].topKey() >= best)
+        m_heaps[dir].clear();
+    if (m_heaps[0].empty() && m_heaps[1].empty())
+      break;
+    const int dir = m_heaps[1].empty() ||
+      (!m_heaps[0].empty() && m_heaps[0].topKey() <= m_heaps[1].topKey()) ?
+      0 : 1;
+    const int u = m_heaps[dir].pop();
+    const std::vector<double> &dist = m_dist[dir];
+    if (m_stamps[1 - dir][u] == m_stamp &&
+        dist[u] + m_dist[1 - dir][u] < best)
+    {
+      best = dist[u] + m_dist[1 - dir][u];
+      meet = u;
+    }
+
+    // the node is stalled if a node contracted after it is reached by
+    // a shorter path through a link to it, then the search does not go on
+    // from it (stall-on-demand)
+    const std::vector<int> &inOffsets = dir == 0 ? ch.m_downOffsets :
+                                                   ch.m_upOffsets;
+    const std::vector<int> &inNodes = dir == 0 ? ch.m_downNodes :
+                                                 ch.m_upNodes;
+    const std::vector<double> &inLengths = dir == 0 ? ch.m_downLengths :
+                                                      ch.m_upLengths;
+    bool stalled = false;
+    for (int j = inOffsets[u]; j < inOffsets[u + 1] && !stalled; j++)
+    {
+      const int x = inNodes[j];
+      stalled = m_stamps[dir][x] == m_stamp &&
+                dist[x] + inLengths[j] < dist[u];
+    }
+    if (stalled)
+      continue;
+
+    const std::vector<int> &offsets = dir == 0 ? ch.m_upOffsets :
+                                                 ch.m_downOffsets;
+    const std::vector<int> &nodes = dir == 0 ? ch.m_upNodes :
+                                               ch.m_downNodes;
+    const std::vector<double> &lengths = dir == 0 ? ch.m_upLengths :
+                                                    ch.m_downLengths;
+    for (int j = offsets[u]; j < offsets[u + 1]; j++)
+      sg_Label(m_dist[dir], m_parents[dir], m_parentLinks[dir],
+               m_stamps[dir], m_stamp, m_heaps[dir], nodes[j],
+               dist[u] + lengths[j], u, j);
+  }
+
+  if (meet < 0)
+    return -1;
+  if (path != NULL)
+  {
+    // the upward links from src to the meeting node, in reverse
+    std::vector<int> links;
+    for (int x = meet; m_parents[0][x] >= 0; x = m_parents[0][x])
+      links.push_back(m_parentLinks[0][x]);
+    path->push_back(src);
+    int from = src;
+    for (size_t k = links.size(); k-- > 0; )
+    {
+      const int j = links[k];
+      appendLink(from, ch.m_upNodes[j], ch.m_upMiddles[j], *path);
+      from = ch.m_upNodes[j];
+    }
+    // the downward links from the meeting node to dst
+    for (int x = meet; m_parents[1][x] >= 0; x = m_parents[1][x])
+    {
+      const int j = m_parentLinks[1][x];
+      appendLink(x, m_parents[1][x], ch.m_downMiddles[j], *path);
+    }
+  }
+  return best;
+}
+
+void CHQuery::selectTargets(const std::vector<int> &targets)
+{
+  const ContractionHierarchy &ch = m_ch;
+  const int nc = ch.nCount();
+
+  // the targets and the nodes reachable from them over downward links
+  // backwards, i.e. all nodes a downward path to a target may pass
+  std::vector<int> pos(nc, -1);
+  m_selected.clear();
+  for (size_t i = 0; i < targets.size(); i++)
+    if (pos[targets[i]] < 0)
+    {
+      pos[targets[i]] = 0;
+      m_selected.push_back(targets[i]);
+    }
+  for (size_t k = 0; k < m_selected.size(); k++)
+  {
+    const int v = m_selected[k];
+    for (int j = ch.m_downOffsets[v]; j < ch.m_downOffsets[v + 1]; j++)
+    {
+      const int x = ch.m_downNodes[j];
+      if (pos[x] < 0)
+      {
+        pos[x] = 0;
+        m_selected.push_back(x);
+      }
+    }
+  }
+
+  std::vector<std::pair<int, int> > order(m_selected.size());
+  for (size_t k = 0; k < m_selected.size(); k++)
+    order[k] = std::make_pair(-ch.m_ranks[m_selected[k]], m_selected[k]);
+  std::sort(order.begin(), order.end());
+  for (size_t k = 0; k < order.size(); k++)
+  {
+    m_selected[k] = order[k].second;
+    pos[m_selected[k]] = (int)k;
+  }
+
+  m_targetPos.resize(targets.size());
+  for (size_t i = 0; i < targets.size(); i++)
+    m_targetPos[i] = pos[targets[i]];
+
+  // downward links of the selected nodes in the order of m_selected, their
+  // sources given by positions in m_selected
+  m_selOffsets.resize(m_selected.size() + 1);
+  m_selSources.clear();
+  m_selLengths.clear();
+  for (size_t k = 0; k < m_selected.size(); k++)
+  {
+    const int v = m_selected[k];
+    m_selOffsets[k] = (int)m_selSources.size();
+    for (int j = ch.m_downOffsets[v]; j < ch.m_downOffsets[v + 1]; j++)
+    {
+      m_selSources.push_back(pos[ch.m_downNodes[j]]);
+      m_selLengths.push_back(ch.m_downLengths[j]);
+    }
+  }
+  m_selOffsets[m_selected.size()] = (int)m_selSources.size();
+  m_selectedDist.resize(m_selected.size());
+}
+
+void CHQuery::distances(int src, std::vector<double> &dists)
+{
+  start();
+  upwardSearch(0, src, Alg::INF);
+
+  // the nodes are swept in the order of decreasing ranks, so that
+  // the distances of the nodes linked to a node downwards are final
+  // when the node is reached (PHAST restricted to the selected nodes)
+  const std::vector<double> &up = m_dist[0];
+  const std::vector<unsigned> &stamps = m_stamps[0];
+  for (size_t k = 0; k < m_selected.size(); k++)
+  {
+    const int v = m_selected[k];
+    double d = stamps[v] == m_stamp ? up[v] : Alg::INF;
+    for (int j = m_selOffsets[k]; j < m_selOffsets[k + 1]; j++)
+    {
+      const double dx = m_selectedDist[m_selSources[j]] + m_selLengths[j];
+      if (dx < d)
+        d = dx;
+    }
+    m_selectedDist[k] = d;
+  }
+
+  dists.resize(m_targetPos.size());
+  for (size_t i = 0; i < m_targetPos.size(); i++)
+  {
+    const double d = m_selectedDist[m_targetPos[i]];
+    dists[i] = d < Alg::INF ? d : -1;
+  }
+}
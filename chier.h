@@ -0,0 +1,132 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+#include <iostream>
+#include "Graphs/libgraphs.h"
+#include "Graphs/node.h"
+#include "Graphs/csrgraph.h"
+#include "Graphs/dheap.h"
+
+#ifndef CHIER_HEADER_FILE_INCLUDED
+#define CHIER_HEADER_FILE_INCLUDED
+
+/*
+  Contraction hierarchy of a graph for repeated shortest path queries
+  (Geisberger et al.)
+  The nodes are contracted one by one in the order of their importance,
+  shortcuts being added between the neighbors of a contracted node where
+  it lies on the only shortest path between them; a query then searches
+  from both ends only towards the nodes contracted later
+  Nodes are identified by their indices in the snapshot the hierarchy is
+  built from, e.g. by m_id for a snapshot of a whole graph; the hierarchy
+  does not follow later changes to the graph
+  Links of arbitrary nonnegative lengths are supported, directed or not
+  The upward links of node i, the links to nodes contracted after it, are
+  the entries [m_upOffsets[i]; m_upOffsets[i + 1]) of the m_upNodes,
+  m_upLengths, and m_upMiddles arrays, the downward links of node i,
+  the links to it from the nodes contracted after it, are the entries
+  [m_downOffsets[i]; m_downOffsets[i + 1]) of the m_downNodes,
+  m_downLengths, and m_downMiddles arrays; a middle node is the contracted
+  node a shortcut bypasses, -1 for links of the graph
+*/
+class LIBGRAPHS_API ContractionHierarchy
+{
+public:
+  // positions of the nodes in the contraction order
+  std::vector<int> m_ranks;
+
+  std::vector<int> m_upOffsets;
+  std::vector<int> m_upNodes;
+  std::vector<double> m_upLengths;
+  std::vector<int> m_upMiddles;
+
+  std::vector<int> m_downOffsets;
+  std::vector<int> m_downNodes;
+  std::vector<double> m_downLengths;
+  std::vector<int> m_downMiddles;
+
+  // numbers of nodes settled by a witness search before it gives up and
+  // a shortcut is added, and by the cheaper searches estimating how many
+  // shortcuts the contraction of a node would add
+  enum { WITNESS_SETTLE_LIMIT = 500, ESTIMATE_SETTLE_LIMIT = 50 };
+
+  void clear();
+
+  // contracts the nodes of g, inactive nodes and links are ignored if
+  // activeOnly is true; throws an exception if a link of a negative length
+  // is detected
+  void build(const CsrGraph &g, bool activeOnly);
+  // builds the hierarchy for a snapshot of nodes made with Alg::BuildCsr,
+  // nodes are identified by their position in the array
+  void build(const PNodeVector &nodes, bool activeOnly);
+
+  inline int nCount() const { return (int)m_ranks.size(); }
+  // returns the number of links including shortcuts
+  inline int numLinks() const { return (int)m_upNodes.size() +
+                                       (int)m_downNodes.size(); }
+
+  // binary serialization, throws an exception on I/O errors or if
+  // the input is not a hierarchy written by write
+  void write(std::ostream &os) const;
+  void write(const char *path) const;
+  void read(std::istream &is);
+  void read(const char *path);
+};
+
+/*
+  Working state of shortest path queries on a contraction hierarchy
+  A query object is bound to a hierarchy, several of them may run
+  concurrently on the same hierarchy
+*/
+class LIBGRAPHS_API CHQuery
+{
+  const ContractionHierarchy &m_ch;
+
+  // state of the upward searches from the source (0) and from the target
+  // (1), valid for the nodes whose stamps equal m_stamp
+  std::vector<double> m_dist[2];
+  std::vector<int> m_parents[2];
+  std::vector<int> m_parentLinks[2];
+  std::vector<unsigned> m_stamps[2];
+  unsigned m_stamp;
+  DHeap m_heaps[2];
+
+  // nodes selected by selectTargets in the order of decreasing ranks,
+  // the positions of the targets in that list, the downward links of
+  // the selected nodes with the sources given by their positions, and
+  // the distances of the selected nodes from the source of the last
+  // one-to-many query
+  std::vector<int> m_selected;
+  std::vector<int> m_targetPos;
+  std::vector<int> m_selOffsets;
+  std::vector<int> m_selSources;
+  std::vector<double> m_selLengths;
+  std::vector<double> m_selectedDist;
+
+  void start();
+  void upwardSearch(int dir, int src, double bound);
+  void appendLink(int from, int to, int middle,
+                  std::vector<int> &path) const;
+
+public:
+  CHQuery(const ContractionHierarchy &ch);
+
+  // returns the distance from src to dst or -1 if dst is not reachable,
+  // stores the path from src to dst in path if it is not NULL
+  double distance(int src, int dst, std::vector<int> *path = NULL);
+
+  // one-to-many queries: selectTargets prepares the part of the hierarchy
+  // leading to the targets, then each call to distances stores
+  // the distances from src to the targets in dists, in the order of
+  // the targets, -1 for the unreachable ones; each call takes time
+  // proportional to the size of the selected part
+  void selectTargets(const std::vector<int> &targets);
+  void distances(int src, std::vector<double> &dists);
+};
+
+#endif // CHIER_HEADER_FILE_INCLUDED
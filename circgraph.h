@@ -33,6 +33,13 @@ public:
   {
   }
 
+  virtual Graph *clone() const
+  {
+    CircGraph *ret = new CircGraph();
+    copyTo(*ret);
+    return ret;
+  }
+
   void GenerateCircER(int n, double k, double b);
   void GenerateCircSF(int n, double k, double g, double b);
 };
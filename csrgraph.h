@@ -0,0 +1,91 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+#include "Graphs/libgraphs.h"
+#include "Graphs/node.h"
+
+#ifndef CSRGRAPH_HEADER_FILE_INCLUDED
+#define CSRGRAPH_HEADER_FILE_INCLUDED
+
+/*
+  Immutable compressed sparse row snapshot of a graph built by Graph::freeze
+  Nodes are identified by their index in m_nodes, links by their index
+  in m_links; the snapshot does not follow later changes to the graph
+  Out-links of node i are the entries [m_offsets[i]; m_offsets[i + 1]) of
+  the m_targets, m_linkIxs, m_lengths, m_weights, and m_linkDactTimes arrays,
+  in-links of node i are the entries [m_inOffsets[i]; m_inOffsets[i + 1]) of
+  the m_inSources, m_inLinkIxs, m_inLengths, m_inWeights, and
+  m_inLinkDactTimes arrays
+*/
+class LIBGRAPHS_API CsrGraph
+{
+public:
+  PNodeVector m_nodes;
+  PLinkDataVector m_links;
+
+  std::vector<int> m_nodeDactTimes;
+
+  std::vector<int> m_offsets;
+  std::vector<int> m_targets;
+  std::vector<int> m_linkIxs;
+  std::vector<double> m_lengths;
+  std::vector<double> m_weights;
+  std::vector<int> m_linkDactTimes;
+
+  std::vector<int> m_inOffsets;
+  std::vector<int> m_inSources;
+  std::vector<int> m_inLinkIxs;
+  std::vector<double> m_inLengths;
+  std::vector<double> m_inWeights;
+  std::vector<int> m_inLinkDactTimes;
+
+  // common length of all links, -1 if the lengths differ or there are
+  // no links
+  double m_uniformLength;
+
+  CsrGraph() : m_uniformLength(-1)
+  {
+  }
+
+  void clear()
+  {
+    m_nodes.clear();
+    m_links.clear();
+    m_nodeDactTimes.clear();
+    m_offsets.clear();
+    m_targets.clear();
+    m_linkIxs.clear();
+    m_lengths.clear();
+    m_weights.clear();
+    m_linkDactTimes.clear();
+    m_inOffsets.clear();
+    m_inSources.clear();
+    m_inLinkIxs.clear();
+    m_inLengths.clear();
+    m_inWeights.clear();
+    m_inLinkDactTimes.clear();
+    m_uniformLength = -1;
+  }
+
+  // sets m_uniformLength from m_lengths
+  void findUniformLength()
+  {
+    m_uniformLength = m_lengths.empty() ? -1 : m_lengths[0];
+    for (size_t j = 1; j < m_lengths.size() && m_uniformLength >= 0; j++)
+      if (m_lengths[j] != m_uniformLength)
+        m_uniformLength = -1;
+  }
+
+  inline int nCount() const { return (int)m_nodes.size(); }
+  inline int ldCount() const { return (int)m_links.size(); }
+  inline int numLinks(int i) const { return m_offsets[i + 1] - m_offsets[i]; }
+  inline int numInLinks(int i) const
+    { return m_inOffsets[i + 1] - m_inOffsets[i]; }
+};
+
+#endif // CSRGRAPH_HEADER_FILE_INCLUDED
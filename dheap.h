@@ -0,0 +1,129 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+
+#ifndef DHEAP_HEADER_FILE_INCLUDED
+#define DHEAP_HEADER_FILE_INCLUDED
+
+/*
+  Indexed d-ary min-heap of elements with dense IDs from 0 to count() - 1
+  keyed by doubles
+  An element is held at most once, its key is decreased in place rather
+  than by pushing another entry, so the heap never grows beyond count()
+  entries; a 4-ary heap is shallower than a binary one and the children of
+  an entry are adjacent in memory
+  Clearing takes time proportional to the number of held elements
+*/
+class DHeap
+{
+  enum { ARITY = 4 };
+
+  // held element IDs in the heap order and their keys
+  std::vector<int> m_items;
+  std::vector<double> m_keys;
+  // positions of the elements in m_items, -1 for elements not held
+  std::vector<int> m_pos;
+
+  inline void place(int p, int item, double key)
+  {
+    m_items[p] = item;
+    m_keys[p] = key;
+    m_pos[item] = p;
+  }
+
+  void siftUp(int p, int item, double key)
+  {
+    while (p > 0)
+    {
+      const int parent = (p - 1) / ARITY;
+      if (m_keys[parent] <= key)
+        break;
+      place(p, m_items[parent], m_keys[parent]);
+      p = parent;
+    }
+    place(p, item, key);
+  }
+
+  void siftDown(int p, int item, double key)
+  {
+    const int size = (int)m_items.size();
+    for (;;)
+    {
+      const int first = p * ARITY + 1;
+      if (first >= size)
+        break;
+      const int last = first + ARITY < size ? first + ARITY : size;
+      int child = first;
+      for (int c = first + 1; c < last; c++)
+        if (m_keys[c] < m_keys[child])
+          child = c;
+      if (m_keys[child] >= key)
+        break;
+      place(p, m_items[child], m_keys[child]);
+      p = child;
+    }
+    place(p, item, key);
+  }
+
+public:
+  // makes room for count elements, none of them held
+  void reset(int count)
+  {
+    m_items.clear();
+    m_keys.clear();
+    m_pos.assign(count, -1);
+  }
+
+  void clear()
+  {
+    for (size_t i = 0; i < m_items.size(); i++)
+      m_pos[m_items[i]] = -1;
+    m_items.clear();
+    m_keys.clear();
+  }
+
+  inline int count() const { return (int)m_pos.size(); }
+  inline int size() const { return (int)m_items.size(); }
+  inline bool empty() const { return m_items.empty(); }
+  inline bool contains(int i) const { return m_pos[i] >= 0; }
+  inline double key(int i) const { return m_keys[m_pos[i]]; }
+
+  // returns the element of the smallest key and the key
+  inline int top() const { return m_items[0]; }
+  inline double topKey() const { return m_keys[0]; }
+
+  // adds an element which is not held
+  void push(int i, double key)
+  {
+    m_items.push_back(i);
+    m_keys.push_back(key);
+    siftUp((int)m_items.size() - 1, i, key);
+  }
+
+  // lowers the key of a held element
+  inline void decrease(int i, double key)
+  {
+    siftUp(m_pos[i], i, key);
+  }
+
+  // removes and returns the element of the smallest key
+  int pop()
+  {
+    const int ret = m_items[0];
+    m_pos[ret] = -1;
+    const int item = m_items.back();
+    const double key = m_keys.back();
+    m_items.pop_back();
+    m_keys.pop_back();
+    if (!m_items.empty())
+      siftDown(0, item, key);
+    return ret;
+  }
+};
+
+#endif // DHEAP_HEADER_FILE_INCLUDED
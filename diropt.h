@@ -0,0 +1,74 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+#include <stdint.h>
+
+#ifndef DIROPT_HEADER_FILE_INCLUDED
+#define DIROPT_HEADER_FILE_INCLUDED
+
+/*
+  Direction choice of a direction-optimizing BFS (Beamer et al.)
+  A level is expanded top-down, from the frontier over its nodes' links,
+  while the frontier's links are few compared to the links of the nodes
+  not visited yet; otherwise it is expanded bottom-up, each node not visited
+  yet looking for a parent in the frontier and stopping at the first one
+  A BFS switches back to top-down steps once the frontier shrinks below
+  a fraction of the nodes
+*/
+class DirOptPolicy
+{
+  bool m_bottomUp;
+  int m_prevFrontier;
+
+public:
+  enum { ALPHA = 14, BETA = 24 };
+
+  DirOptPolicy() : m_bottomUp(false), m_prevFrontier(0)
+  {
+  }
+
+  // returns true if the next level should be expanded bottom-up,
+  // frontier is the number of nodes in the frontier, frontierLinks
+  // the number of their links followed top-down, unvisitedLinks the number
+  // of links followed bottom-up by the nodes not visited yet, count
+  // the number of nodes
+  bool bottomUp(int frontier, double frontierLinks, double unvisitedLinks,
+                int count)
+  {
+    if (!m_bottomUp)
+      m_bottomUp = frontierLinks * ALPHA > unvisitedLinks &&
+                   frontier > m_prevFrontier;
+    else
+      m_bottomUp = !((double)frontier * BETA < count &&
+                     frontier < m_prevFrontier);
+    m_prevFrontier = frontier;
+    return m_bottomUp;
+  }
+};
+
+/*
+  Bitmap of the nodes in a BFS frontier
+*/
+class FrontierBitmap
+{
+  std::vector<uint64_t> m_bits;
+
+public:
+  inline void reset(int count) { m_bits.assign((count + 63) >> 6, 0); }
+  inline bool empty() const { return m_bits.empty(); }
+  // returns the number of nodes the bitmap has room for
+  inline int size() const { return (int)m_bits.size() * 64; }
+  inline void set(int i) { m_bits[i >> 6] |= (uint64_t)1 << (i & 63); }
+  inline void unset(int i) { m_bits[i >> 6] &= ~((uint64_t)1 << (i & 63)); }
+  inline bool test(int i) const
+  {
+    return ((m_bits[i >> 6] >> (i & 63)) & 1) != 0;
+  }
+};
+
+#endif // DIROPT_HEADER_FILE_INCLUDED
@@ -8,6 +8,7 @@
 #include "stdafx.h"
 #include "Graphs/graph.h"
 #include "Graphs/alg.h"
+#include <cerrno>
 
 
 static bool check_tag(Node *n) { return n->m_tag < 2; }
@@ -15,6 +16,7 @@ static bool check_tag(Node *n) { return n->m_tag < 2; }
 bool Graph::linkNodesByTags(int sumDegrees, bool strict)
 {
   PNodeVector &nv = nodes();
+  reserveLinks(ldCount() + sumDegrees / 2);
 
   Node **nodes = new Node *[sumDegrees];
   auto_del<Node *> del_nodes(nodes, true);
@@ -187,8 +189,9 @@ public:
 bool Graph::linkNodesBA(int m)
 {
   PNodeVector &nv = nodes();
+  reserveLinks(ldCount() + (int)nv.size() * m);
   Node **pNodes = new Node *[nv.size()];
-  memcpy(pNodes, &m_nodes[0], nv.size() * sizeof(Node *));
+  memcpy(pNodes, &nv[0], nv.size() * sizeof(Node *));
   RandomSelector<Node> rsel(pNodes, (int)nv.size(), NULL);
 
   int connCount = 0;
@@ -225,6 +228,7 @@ bool Graph::linkNodesBA(int m)
 void Graph::linkNodesRLat(int a, int b)
 {
   PNodeVector &nv = nodes();
+  reserveLinks(ldCount() + 2 * a * b);
 
   for (int i = 0; i < a; i++)
   {
@@ -245,7 +249,7 @@ void Graph::linkByDistance(double r, Node *nd, PNodeList &bin, bool sameBin)
   for (PNodeList::iterator it = bin.begin(); it != bin.end(); it++)
   {
     Node *oth = *it;
-    if (!sameBin || nd->m_tag < oth->m_tag)
+    if (!sameBin || nd->m_id < oth->m_id)
       if (nd->m_coords.distance2D((*it)->m_coords) <= r)
         linkSimple(nd, *it, false);
   }
@@ -259,7 +263,6 @@ void Graph::linkNodesSpatial(double r, double w, double h)
   {
     Node *nd = ns[i];
     nd->m_coords.set(RAND_0_1 * w, RAND_0_1 * h);
-    nd->m_tag = i;
   }
 
   if (r <= 0)
@@ -418,68 +421,326 @@ void Graph::getActSrcLinks(SrcLinkVector &ret) const
   }
 }
 
+void Graph::freeze(CsrGraph &ret) const
+{
+  const PNodeVector &nv = nodes();
+  const PLinkDataVector &ldv = linkData();
+  const int nc = (int)nv.size();
+
+  ret.clear();
+  ret.m_nodes = nv;
+  ret.m_links = ldv;
+
+  int outCount = 0, inCount = 0;
+  ret.m_nodeDactTimes.resize(nc);
+  for (int i = 0; i < nc; i++)
+  {
+    ret.m_nodeDactTimes[i] = nv[i]->m_dactTime;
+    outCount += nv[i]->numLinks();
+    inCount += nv[i]->numInLinks();
+  }
+
+  ret.m_offsets.resize(nc + 1);
+  ret.m_targets.resize(outCount);
+  ret.m_linkIxs.resize(outCount);
+  ret.m_lengths.resize(outCount);
+  ret.m_weights.resize(outCount);
+  ret.m_linkDactTimes.resize(outCount);
+
+  ret.m_inOffsets.resize(nc + 1);
+  ret.m_inSources.resize(inCount);
+  ret.m_inLinkIxs.resize(inCount);
+  ret.m_inLengths.resize(inCount);
+  ret.m_inWeights.resize(inCount);
+  ret.m_inLinkDactTimes.resize(inCount);
+
+  int ox = 0, ix = 0;
+  for (int i = 0; i < nc; i++)
+  {
+    ret.m_offsets[i] = ox;
+    const LinkVector &links = nv[i]->links();
+    for (size_t j = 0; j < links.size(); j++, ox++)
+    {
+      const LinkData *ld = links[j].d;
+      ret.m_targets[ox] = links[j].n->m_id;
+      ret.m_linkIxs[ox] = ld->m_id;
+      ret.m_lengths[ox] = ld->m_length;
+      ret.m_weights[ox] = ld->m_weight;
+      ret.m_linkDactTimes[ox] = ld->m_dactTime;
+    }
+
+    ret.m_inOffsets[i] = ix;
+    const LinkVector &inLinks = nv[i]->inLinks();
+    for (size_t j = 0; j < inLinks.size(); j++, ix++)
+    {
+      const LinkData *ld = inLinks[j].d;
+      ret.m_inSources[ix] = inLinks[j].n->m_id;
+      ret.m_inLinkIxs[ix] = ld->m_id;
+      ret.m_inLengths[ix] = ld->m_length;
+      ret.m_inWeights[ix] = ld->m_weight;
+      ret.m_inLinkDactTimes[ix] = ld->m_dactTime;
+    }
+  }
+  ret.m_offsets[nc] = ox;
+  ret.m_inOffsets[nc] = ix;
+  ret.findUniformLength();
+}
+
+// return the counterparts in ret of a node or a link of src,
+// NULL if it does not belong to src
+static Node *sg_nodeCopy(const Graph &src, const Graph &ret, const Node *n)
+{
+  if (n == NULL || n->m_id < 0 || n->m_id >= src.nCount() ||
+      src.node(n->m_id) != n)
+    return NULL;
+  return ret.node(n->m_id);
+}
+
+static LinkData *sg_linkCopy(const Graph &src, const Graph &ret,
+                             const LinkData *ld)
+{
+  const PLinkDataVector &ldv = src.linkData();
+  if (ld == NULL || ld->m_id < 0 || ld->m_id >= (int)ldv.size() ||
+      ldv[ld->m_id] != ld)
+    return NULL;
+  return ret.linkData()[ld->m_id];
+}
+
+static void sg_relocateLinks(const Graph &src, const Graph &ret,
+                             LinkVector &links)
+{
+  for (size_t j = 0; j < links.size(); j++)
+  {
+    links[j].n = sg_nodeCopy(src, ret, links[j].n);
+    links[j].d = sg_linkCopy(src, ret, links[j].d);
+    if (links[j].n == NULL || links[j].d == NULL)
+      throw Exception("Unable to copy a graph with links to nodes or "
+                      "link data outside of it");
+  }
+}
+
+void Graph::copyTo(Graph &ret) const
+{
+  const int nc = nCount();
+  const int lc = ldCount();
+
+  ret.m_nodes->clear();
+  ret.m_nodeMap->clear();
+  ret.m_linkData->clear();
+  ret.invalidateActivation();
+  delete [] ret.m_nodesByDegree;
+  ret.m_nodesByDegree = NULL;
+
+  ret.m_netFactory->resizeNodes(0);
+  ret.m_netFactory->resizeLinks(0);
+  ret.m_netFactory->reserveNodes(nc);
+  ret.m_netFactory->reserveLinks(lc);
+  ret.m_nodes->reserve(nc);
+  ret.m_nodeMap->reserve(nc);
+  ret.m_linkData->reserve(lc);
+
+  // copies are created in the ID order and keep the IDs of the originals
+  for (int i = 0; i < lc; i++)
+    ret.m_linkData->push_back(ret.m_netFactory->copyLink((*m_linkData)[i]));
+  for (int i = 0; i < nc; i++)
+  {
+    Node *n = ret.m_netFactory->copyNode((*m_nodes)[i]);
+    ret.m_nodes->push_back(n);
+    (*ret.m_nodeMap)[n->m_name] = n;
+  }
+
+  // pointers to the original nodes and links are relocated through IDs
+  for (int i = 0; i < lc; i++)
+  {
+    LinkData *ld = (*ret.m_linkData)[i];
+    ld->m_src = sg_nodeCopy(*this, ret, ld->m_src);
+    ld->m_dst = sg_nodeCopy(*this, ret, ld->m_dst);
+  }
+  for (int i = 0; i < nc; i++)
+  {
+    Node *n = (*ret.m_nodes)[i];
+    sg_relocateLinks(*this, ret, n->links());
+    sg_relocateLinks(*this, ret, n->inLinks());
+    n->m_ntag = NULL;
+  }
+}
+
+void Graph::compact()
+{
+  Graph copy(m_netFactory->newINetFactory());
+  copyTo(copy);
+  compacting(copy);
+
+  // the copy takes the original memory and frees it when destroyed
+  std::swap(m_netFactory, copy.m_netFactory);
+  std::swap(m_nodes, copy.m_nodes);
+  std::swap(m_nodeMap, copy.m_nodeMap);
+  std::swap(m_linkData, copy.m_linkData);
+  std::swap(m_nodesByDegree, copy.m_nodesByDegree);
+  invalidateActivation();
+}
+
+// returns the number of bytes in the heap buffer of s assuming
+// the common 15 character small string buffer
+static size_t sg_strMemory(const std::string &s)
+{
+  return s.capacity() > 15 ? s.capacity() + 1 : 0;
+}
+
+MemoryUsage Graph::memoryUsage() const
+{
+  const int nc = nCount();
+  const int lc = ldCount();
+  MemoryUsage ret;
+
+  ret.m_nodes = nc * m_netFactory->nodeSize();
+  ret.m_links = lc * m_netFactory->linkSize();
+  ret.m_slack = m_netFactory->nodesMemory() + m_netFactory->linksMemory() -
+                ret.m_nodes - ret.m_links;
+
+  for (int i = 0; i < nc; i++)
+  {
+    const Node *n = (*m_nodes)[i];
+    ret.m_adjacency += n->adjacencyMemory();
+    ret.m_maps += n->indicesMemory();
+    ret.m_names += sg_strMemory(n->m_name);
+  }
+  for (int i = 0; i < lc; i++)
+    ret.m_names += sg_strMemory((*m_linkData)[i]->m_name);
+
+  // hash nodes of the name index hold a key, a value, a next pointer and
+  // a cached hash
+  ret.m_maps += m_nodeMap->size() * (sizeof(StrPNodeMap::value_type) +
+                                     2 * sizeof(void *));
+  ret.m_maps += m_nodeMap->bucket_count() * sizeof(void *);
+  for (StrPNodeMap::const_iterator it = m_nodeMap->begin();
+       it != m_nodeMap->end(); it++)
+    ret.m_names += sg_strMemory(it->first);
+
+  ret.m_maps += m_nodes->capacity() * sizeof(Node *);
+  ret.m_maps += m_linkData->capacity() * sizeof(LinkData *);
+  if (m_nodesByDegree != NULL)
+    ret.m_maps += nc * sizeof(Node *);
+  ret.m_maps += m_nodeAct.memoryUsage() + m_linkAct.memoryUsage();
+  return ret;
+}
+
+
+void Graph::SaveActivation(ActivationState &ret) const
+{
+  const int nc = nCount();
+  const int lc = ldCount();
+  ret.m_nodeDactTimes.resize(nc);
+  ret.m_linkDactTimes.resize(lc);
+  for (int i = 0; i < nc; i++)
+    ret.m_nodeDactTimes[i] = (*m_nodes)[i]->m_dactTime;
+  for (int i = 0; i < lc; i++)
+    ret.m_linkDactTimes[i] = (*m_linkData)[i]->m_dactTime;
+}
+
+void Graph::RestoreActivation(const ActivationState &state)
+{
+  const int nc = nCount();
+  const int lc = ldCount();
+  if ((int)state.m_nodeDactTimes.size() != nc ||
+      (int)state.m_linkDactTimes.size() != lc)
+    throw Exception("The activation state does not match the graph");
+  for (int i = 0; i < nc; i++)
+    (*m_nodes)[i]->m_dactTime = state.m_nodeDactTimes[i];
+  for (int i = 0; i < lc; i++)
+    (*m_linkData)[i]->m_dactTime = state.m_linkDactTimes[i];
+  invalidateActivation();
+}
+
+void Graph::syncNodeActivation()
+{
+  if (m_nodeAct.valid())
+    return;
+  const int nc = nCount();
+  m_nodeAct.reset(nc);
+  for (int i = 0; i < nc; i++)
+    if ((*m_nodes)[i]->m_dactTime >= 0)
+      m_nodeAct.deact(i);
+}
+
+void Graph::syncLinkActivation()
+{
+  if (m_linkAct.valid())
+    return;
+  const int lc = ldCount();
+  m_linkAct.reset(lc);
+  for (int i = 0; i < lc; i++)
+    if ((*m_linkData)[i]->m_dactTime >= 0)
+      m_linkAct.deact(i);
+}
+
 size_t Graph::ActAll()
 {
   PNodeVector &nv = nodes();
-
   for (size_t i = 0; i < nv.size(); i++)
     nv[i]->m_dactTime = -1;
+  if (m_nodeAct.valid())
+    m_nodeAct.actAll();
   return nv.size();
 }
 
-size_t Graph::Deact(size_t needDeact, size_t haveAct, int dactTime)
+size_t Graph::Deact(size_t needDeact, size_t /*haveAct*/, int dactTime)
 {
-  PNodeVector &nv = nodes();
+  syncNodeActivation();
 
-  size_t ret = 0;
-  double p1 = haveAct > 0 ? (double)needDeact / haveAct : 0;
-  for (size_t i = 0; i < nv.size(); i++)
+  PNodeVector &nv = nodes();
+  while (needDeact > 0 && m_nodeAct.numActive() > 0)
   {
-    if (nv[i]->m_dactTime >= 0)
-      continue;
-    if (p1 < RAND_0_1)
-      ret++;
-    else
+    int pos = (int) (m_nodeAct.numActive() * RAND_0_1);
+    int id = m_nodeAct.at(pos);
+    if (nv[id]->m_dactTime >= 0)
     {
-      nv[i]->m_dactTime = dactTime;
-      needDeact--;
+      // deactivated directly, the index is out of date: it is rebuilt
+      // and the recorded deactivation time is kept
+      m_nodeAct.invalidate();
+      syncNodeActivation();
+      continue;
     }
-    haveAct --;
-    p1 = haveAct > 0 ? (double)needDeact / haveAct : 0;
+    m_nodeAct.deact(id);
+    nv[id]->m_dactTime = dactTime;
+    needDeact--;
   }
-  return ret;
+  return m_nodeAct.numActive();
 }
 
 size_t Graph::ActAllLinks()
 {
   PLinkDataVector &lData = linkData();
-
   for (size_t i = 0; i < lData.size(); i++)
     lData[i]->m_dactTime = -1;
+  if (m_linkAct.valid())
+    m_linkAct.actAll();
   return lData.size();
 }
 
-size_t Graph::DeactLinks(size_t needDeact, size_t haveAct, int dactTime)
+size_t Graph::DeactLinks(size_t needDeact, size_t /*haveAct*/,
+                         int dactTime)
 {
-  PLinkDataVector &lData = linkData();
+  syncLinkActivation();
 
-  size_t ret = 0;
-  double p1 = haveAct > 0 ? (double)needDeact / haveAct : 0;
-  for (size_t i = 0; i < lData.size(); i++)
+  PLinkDataVector &lData = linkData();
+  while (needDeact > 0 && m_linkAct.numActive() > 0)
   {
-    if (lData[i]->m_dactTime >= 0)
-      continue;
-    if (p1 < RAND_0_1)
-      ret++;
-    else
+    int pos = (int) (m_linkAct.numActive() * RAND_0_1);
+    int id = m_linkAct.at(pos);
+    if (lData[id]->m_dactTime >= 0)
     {
-      lData[i]->m_dactTime = dactTime;
-      needDeact--;
+      // deactivated directly, the index is out of date: it is rebuilt
+      // and the recorded deactivation time is kept
+      m_linkAct.invalidate();
+      syncLinkActivation();
+      continue;
     }
-    haveAct --;
-    p1 = haveAct > 0 ? (double)needDeact / haveAct : 0;
+    m_linkAct.deact(id);
+    lData[id]->m_dactTime = dactTime;
+    needDeact--;
   }
-  return ret;
+  return m_linkAct.numActive();
 }
 
 int Graph::DeactSubGraphComponents(int dactTime)
@@ -499,6 +760,7 @@ int Graph::DeactSubGraphComponents(int dactTime)
     else
       nv[i]->m_dactTime = dactTime;
   }
+  m_nodeAct.invalidate();
   return ret;
 }
 
@@ -527,8 +789,12 @@ void Graph::resizeAndResetNodes(size_t n)
   m_nodes->clear();
   m_nodeMap->clear();
   m_linkData->clear();
+  invalidateActivation();
   m_netFactory->resizeNodes(0);
   m_netFactory->resizeLinks(0);
+  m_netFactory->reserveNodes((int)n);
+  m_nodes->reserve(n);
+  m_nodeMap->reserve(n);
   for (size_t i = 0; i < n; i++)
     addNodeSimple(ToString(i));
 
@@ -536,11 +802,19 @@ void Graph::resizeAndResetNodes(size_t n)
   m_nodesByDegree = NULL;
 }
 
+void Graph::reserveLinks(int count)
+{
+  m_linkData->reserve(count);
+  m_netFactory->reserveLinks(count);
+}
+
 
 Node *Graph::parseNode(StringVector &strs, NodeParser<CsvCol> *parser)
 {
   Node *n = m_netFactory->nextNode();
   parser->parse(strs, n);
+  m_nodeAct.invalidate();
+  n->m_id = nCount();
   m_nodes->push_back(n);
   (*m_nodeMap)[n->m_name] = n;
   return n;
@@ -551,8 +825,16 @@ LinkData *Graph::parseLinkData(StringVector &strs, LinkParser<CsvCol> *parser)
   LinkData *ld = m_netFactory->nextLink();
   std::string name1, name2;
   parser->parse(strs, ld, name1, name2);
-  Node *n1 = (*m_nodeMap)[name1];
-  Node *n2 = (*m_nodeMap)[name2];
+  StrPNodeMapIt it1 = m_nodeMap->find(name1);
+  if (it1 == m_nodeMap->end())
+    throw Exception("Unknown node %s in a link", name1.c_str());
+  StrPNodeMapIt it2 = m_nodeMap->find(name2);
+  if (it2 == m_nodeMap->end())
+    throw Exception("Unknown node %s in a link", name2.c_str());
+  Node *n1 = it1->second;
+  Node *n2 = it2->second;
+  m_linkAct.invalidate();
+  ld->m_id = ldCount();
   m_linkData->push_back(ld);
   n1->link(n2, ld);
   if (!ld->m_directed)
@@ -561,19 +843,38 @@ LinkData *Graph::parseLinkData(StringVector &strs, LinkParser<CsvCol> *parser)
 }
 
 
-Node *Graph::addNodeSimple(const std::string &name)
+Node *Graph::createNode(const std::string &name)
 {
   Node *n = m_netFactory->nextNode();
   n->m_name = name;
+  m_nodeAct.invalidate();
+  n->m_id = nCount();
   m_nodes->push_back(n);
+  return n;
+}
+
+Node *Graph::addNodeSimple(const std::string &name)
+{
+  Node *n = createNode(name);
   (*m_nodeMap)[n->m_name] = n;
   return n;
 }
 
+Node *Graph::findOrAddNode(const std::string &name)
+{
+  std::pair<StrPNodeMapIt, bool> res =
+    m_nodeMap->insert(StrPNodeMap::value_type(name, (Node *)NULL));
+  if (res.second)
+    res.first->second = createNode(name);
+  return res.first->second;
+}
+
 LinkData *Graph::linkSimple(Node *n1, Node *n2, bool directed)
 {
   LinkData *ld = m_netFactory->nextLink();
   ld->m_directed = directed;
+  m_linkAct.invalidate();
+  ld->m_id = ldCount();
   (*m_linkData).push_back(ld);
   n1->link(n2, ld);
   if (!directed)
@@ -581,6 +882,55 @@ LinkData *Graph::linkSimple(Node *n1, Node *n2, bool directed)
   return ld;
 }
 
+void Graph::removeLink(LinkData *ld)
+{
+  if (ld->m_id < 0 || ld->m_id >= ldCount() || (*m_linkData)[ld->m_id] != ld)
+    throw Exception("Unable to remove a link not in the graph");
+
+  ld->m_src->unlink(ld->m_dst, ld);
+  if (!ld->m_directed)
+    ld->m_dst->unlink(ld->m_src, ld);
+
+  m_linkAct.invalidate();
+  LinkData *last = m_linkData->back();
+  last->m_id = ld->m_id;
+  (*m_linkData)[ld->m_id] = last;
+  m_linkData->pop_back();
+
+  ld->m_id = -1;
+  m_netFactory->releaseLink(ld);
+
+  delete [] m_nodesByDegree;
+  m_nodesByDegree = NULL;
+}
+
+void Graph::removeNode(Node *n)
+{
+  if (n->m_id < 0 || n->m_id >= nCount() || (*m_nodes)[n->m_id] != n)
+    throw Exception("Unable to remove a node not in the graph");
+
+  while (n->numLinks() > 0)
+    removeLink(n->links().back().d);
+  while (n->numInLinks() > 0)
+    removeLink(n->inLinks().back().d);
+
+  m_nodeAct.invalidate();
+  Node *last = m_nodes->back();
+  last->m_id = n->m_id;
+  (*m_nodes)[n->m_id] = last;
+  m_nodes->pop_back();
+
+  StrPNodeMapIt it = m_nodeMap->find(n->m_name);
+  if (it != m_nodeMap->end() && it->second == n)
+    m_nodeMap->erase(it);
+
+  n->m_id = -1;
+  m_netFactory->releaseNode(n);
+
+  delete [] m_nodesByDegree;
+  m_nodesByDegree = NULL;
+}
+
 
 void Graph::GenerateER(int n, double k)
 {
@@ -675,6 +1025,7 @@ void Graph::URewire(bool strict, int *degrees)
     sum += n->m_tag;
   }
   m_linkData->clear();
+  m_linkAct.invalidate();
   m_netFactory->resizeLinks(0);
 
   linkNodesByTags(sum, strict);
@@ -687,45 +1038,53 @@ void Graph::ClearNodesByPredicate(bool (*chk)(Node *), bool rename,
   SrcLinkVector srcLinks;
   getSrcLinks(srcLinks);
 
+  invalidateActivation();
   m_linkData->clear();
   delete m_nodeMap;
   m_nodeMap = new StrPNodeMap();
 
   const int nc = nCount();
+  m_nodeMap->reserve(nc);
   PNodeVector *oNodes = m_nodes;
   auto_del<PNodeVector> del_oNodes(oNodes, false);
-  for (int i = 0; i < nc; i++)
-  {
-    Node *n = (*oNodes)[i];
-    n->m_tag = chk(n);
-  }
   m_nodes = new PNodeVector();
 
+  // kept nodes are given consecutive IDs, removed ones get -1
   for (int i = 0; i < nc; i++)
   {
     Node *n = (*oNodes)[i];
-    if (n->m_tag > 0)
+    if (chk(n))
     {
       n->reinitLinks();
       if (rename)
         n->m_name = ToString(m_nodes->size());
+      n->m_id = nCount();
       m_nodes->push_back(n);
       (*m_nodeMap)[n->m_name] = n;
     }
-    else if (removed != NULL)
-      removed->push_back(n);
+    else
+    {
+      n->m_id = -1;
+      if (removed != NULL)
+        removed->push_back(n);
+    }
   }
   for (size_t i = 0; i < srcLinks.size(); i++)
   {
     Node *src = srcLinks[i].src;
     Node *dst = srcLinks[i].link.n;
     LinkData *ld = srcLinks[i].link.d;
-    if (src->m_tag && dst->m_tag)
+    if (src->m_id >= 0 && dst->m_id >= 0)
     {
       if (ld->m_directed || src < dst)
+      {
+        ld->m_id = ldCount();
         m_linkData->push_back(ld);
+      }
       src->link(dst, ld);
     }
+    else
+      ld->m_id = -1;
   }
 }
 
@@ -740,11 +1099,13 @@ void Graph::ImposeDegreeCutoff(int cutoff)
   PNodeVector removed;
   sg_sfDegreeCutoff = cutoff;
   ClearNodesByPredicate(sg_isSfDegreeBelowCutoff, true, &removed);
+  m_nodeAct.invalidate();
   for (size_t i = 0; i < removed.size(); i++)
   {
     Node *n = removed[i];
     n->reinitLinks();
     n->m_name = ToString(m_nodes->size());
+    n->m_id = nCount();
     m_nodes->push_back(n);
     (*m_nodeMap)[n->m_name] = n;
   }
@@ -774,12 +1135,26 @@ void Graph::ClearTemporalLinks()
   const int LC = ldCount();
   for (int i = 0; i < NC; i++)
     (*m_nodes)[i]->clearTempLinks();
+
+  // temporary links are released wherever they are in m_linkData,
+  // the remaining links keep their order
+  m_linkAct.invalidate();
   int cnt = 0;
-  for (cnt = 0; cnt < LC; cnt++)
-    if ((*m_linkData)[cnt]->m_isTemp)
-      break;
+  for (int i = 0; i < LC; i++)
+  {
+    LinkData *ld = (*m_linkData)[i];
+    if (ld->m_isTemp)
+    {
+      ld->m_id = -1;
+      m_netFactory->releaseLink(ld);
+    }
+    else
+    {
+      ld->m_id = cnt;
+      (*m_linkData)[cnt++] = ld;
+    }
+  }
   m_linkData->resize(cnt);
-  m_netFactory->resizeLinks(cnt);
 }
 
 
@@ -917,37 +1292,114 @@ void Graph::WriteGdf(const char *gPath,
 }
 
 
+// parses a non-negative integer node name at p and advances p past it,
+// returns -1 if there is none
+static long long sg_parseNumericName(const char *&p)
+{
+  char *end;
+  errno = 0;
+  long long ret = strtoll(p, &end, 10);
+  if (end == p || ret < 0 || errno == ERANGE)
+    return -1;
+  p = end;
+  return ret;
+}
+
+static std::string sg_numericName(long long num)
+{
+  char buf[24];
+  sprintf(buf, "%lld", num);
+  return buf;
+}
+
 void Graph::ReadAdjacency(const char *path, bool prune, int n,
-                          bool containsDuplicates, bool directed)
+                          bool containsDuplicates, bool directed,
+                          bool numericNames)
 {
   std::ifstream ifs(path, std::ios_base::in | std::ios_base::binary);
   if (!ifs.good())
     throw Exception("Unable to open the adjacency input file");
 
+  // nodes indexed by their numeric names below denseLimit, the ones present
+  // before the call are included; the array is bounded by the size of
+  // the file, as a line names at most two nodes in at least four bytes,
+  // and larger names are looked up by name
+  long long denseLimit = 0;
+  if (numericNames)
+  {
+    ifs.seekg(0, std::ios_base::end);
+    const long long fileSize = (long long)ifs.tellg();
+    ifs.seekg(0, std::ios_base::beg);
+    denseLimit = std::min((long long)INT_MAX / 2,
+                          std::max(fileSize / 2, (long long)nCount()) + 1);
+  }
+  PNodeVector byNum;
+  const int oldCount = nCount();
+  for (int i = 0; numericNames && i < oldCount; i++)
+  {
+    const char *p = (*m_nodes)[i]->m_name.c_str();
+    long long num = sg_parseNumericName(p);
+    if (num < 0 || num >= denseLimit || *p != '\0')
+      continue;
+    if (num >= (long long)byNum.size())
+      byNum.resize((size_t)num + 1, NULL);
+    byNum[(size_t)num] = (*m_nodes)[i];
+  }
+
   std::string line;
   while (std::getline(ifs, line))
   {
     Trim(line);
+    if (line.empty() || line[0] == '#')
+      continue;
 
-    StringVector strs;
-    SplitStr(line, strs, " ");
-    std::string &name1 = strs[0];
-    std::string &name2 = strs[1];
-
-    Node *n1, *n2;
-    if (m_nodeMap->find(name1) == m_nodeMap->end())
-      n1 = addNodeSimple(name1);
-    else
-      n1 = (*m_nodeMap)[name1];
-    if (m_nodeMap->find(name2) == m_nodeMap->end())
-      n2 = addNodeSimple(name2);
+    Node *ends[2];
+    if (numericNames)
+    {
+      const char *p = line.c_str();
+      for (int k = 0; k < 2; k++)
+      {
+        long long num = sg_parseNumericName(p);
+        if (num < 0)
+          throw Exception("Non-numeric node name in the adjacency line %s",
+                          line.c_str());
+        if (num >= denseLimit)
+        {
+          ends[k] = findOrAddNode(sg_numericName(num));
+          continue;
+        }
+        const size_t ix = (size_t)num;
+        if (ix >= byNum.size())
+          byNum.resize(std::min((size_t)denseLimit,
+                                std::max(ix + 1, 2 * byNum.size())), NULL);
+        if (byNum[ix] == NULL)
+          byNum[ix] = createNode(sg_numericName(num));
+        ends[k] = byNum[ix];
+      }
+    }
     else
-      n2 = (*m_nodeMap)[name2];
+    {
+      StringVector strs;
+      SplitStr(line, strs, " ");
+      if (strs.size() < 2)
+        throw Exception("Incorrect adjacency line %s", line.c_str());
+      ends[0] = findOrAddNode(strs[0]);
+      ends[1] = findOrAddNode(strs[1]);
+    }
 
+    Node *n1 = ends[0], *n2 = ends[1];
     if (!containsDuplicates || !n1->findLink(n2))
       linkSimple(n1, n2, directed);
   }
 
+  // the nodes created through byNum are indexed by name once here
+  if (numericNames && !prune)
+  {
+    m_nodeMap->reserve(nCount());
+    for (int i = oldCount; i < nCount(); i++)
+      (*m_nodeMap)[(*m_nodes)[i]->m_name] = (*m_nodes)[i];
+  }
+
   if (prune)
   {
     for (int i = 0; i < nCount(); i++)
@@ -967,12 +1419,14 @@ void Graph::WriteAdjacency(const char *fileName, bool gccOnly, bool directed)
   if (gccOnly)
     Alg::AssignUComponentIDs(nv, false);
 
+  // output node numbers indexed by the node ID
+  std::vector<int> nums(nc, -1);
   int offset = 0;
   for (int i = 0; i < nc; i++)
   {
     Node &n = *nv[i];
     if (n.numLinks() > 0 && (!gccOnly || n.m_compId == 0))
-      n.m_tag = i - offset;
+      nums[i] = i - offset;
     else
       offset ++;
   }
@@ -988,8 +1442,9 @@ void Graph::WriteAdjacency(const char *fileName, bool gccOnly, bool directed)
       for (size_t j = 0; j < n1Links.size(); j++)
       {
         Node *n2 = n1Links[j].n;
-        if (n1.m_tag < n2->m_tag || directed)
-          fprintf(f, "%d %d" CSVENDL, n1.m_tag, n2->m_tag);
+        const int num1 = nums[n1.m_id], num2 = nums[n2->m_id];
+        if (num1 < num2 || directed)
+          fprintf(f, "%d %d" CSVENDL, num1, num2);
       }
     }
   }
@@ -10,6 +10,8 @@
 #include "Graphs/netfactory.h"
 #include "Graphs/blkmem.h"
 #include "Graphs/sfdistr.h"
+#include "Graphs/csrgraph.h"
+#include "Graphs/actset.h"
 #include "parsers.h"
 #include "writers.h"
 
@@ -17,6 +19,41 @@
 #ifndef GRAPH_HEADER_FILE_INCLUDED
 #define GRAPH_HEADER_FILE_INCLUDED
 
+// activation times of the nodes and links of a graph indexed by their IDs,
+// see Graph::SaveActivation
+struct ActivationState
+{
+  std::vector<int> m_nodeDactTimes;
+  std::vector<int> m_linkDactTimes;
+};
+
+// numbers of bytes held by a graph, see Graph::memoryUsage
+struct MemoryUsage
+{
+  // node and link objects in use
+  size_t m_nodes;
+  size_t m_links;
+  // link vectors of the nodes including their spare capacity
+  size_t m_adjacency;
+  // heap buffers of node and link names including the name index keys
+  size_t m_names;
+  // name index, neighbor indices, node and link vectors, activation sets
+  size_t m_maps;
+  // factory memory not holding objects in use
+  size_t m_slack;
+
+  MemoryUsage()
+    : m_nodes(0), m_links(0), m_adjacency(0), m_names(0), m_maps(0),
+      m_slack(0)
+  {
+  }
+
+  inline size_t total() const
+  {
+    return m_nodes + m_links + m_adjacency + m_names + m_maps + m_slack;
+  }
+};
+
 
 class LIBGRAPHS_API Graph
 {
@@ -26,7 +63,31 @@ protected:
   StrPNodeMap *m_nodeMap;
   PLinkDataVector *m_linkData;
 
+  // indices of the active nodes and links by their IDs mirroring
+  // m_dactTime for Deact and DeactLinks, invalidated by structural changes
+  // and rebuilt on demand
+  ActiveIndex m_nodeAct;
+  ActiveIndex m_linkAct;
+
+  void syncNodeActivation();
+  void syncLinkActivation();
+
   void resizeAndResetNodes(size_t n);
+  // preallocates memory for count links in total
+  void reserveLinks(int count);
+
+  // replaces the contents of ret, which must use a factory of the same
+  // type, with copies of the nodes and links of this graph
+  void copyTo(Graph &ret) const;
+  // called by compact() once copy holds the copies of the nodes and links,
+  // before the originals are freed
+  virtual void compacting(const Graph & /*copy*/) {}
+
+  // creates a node and appends it to m_nodes without indexing its name
+  Node *createNode(const std::string &name);
+  // returns the node with the given name creating it if there is none,
+  // looks the name up only once
+  Node *findOrAddNode(const std::string &name);
 
   void linkByDistance(double r, Node *nd, PNodeList &lst, bool sameBin);
 
@@ -71,6 +132,13 @@ public:
   virtual Node *addNodeSimple(const std::string &name);
   virtual LinkData *linkSimple(Node *n1, Node *n2, bool directed);
 
+  // remove a link or a node with its links in time proportional to the
+  // degrees of the nodes involved; the last link or node takes the place
+  // (and ID) of the removed one in linkData() or nodes(), and the removed
+  // objects are recycled by the factory
+  void removeLink(LinkData *ld);
+  virtual void removeNode(Node *n);
+
   Node *parseNode(StringVector &strs, NodeParser<CsvCol> *parser);
   LinkData *parseLinkData(StringVector &strs, LinkParser<CsvCol> *parser);
 
@@ -82,6 +150,8 @@ public:
 
   inline int nCount() const { return (int)m_nodes->size(); }
   inline PNodeVector &nodes() const { return *m_nodes; }
+  // returns the node with the given ID, i.e. nodes()[id]
+  inline Node *node(int id) const { return (*m_nodes)[id]; }
   inline StrPNodeMap &nodeMap() { return *m_nodeMap; }
 
   inline int ldCount() const { return (int)m_linkData->size(); }
@@ -96,6 +166,48 @@ public:
   void getSrcLinks(SrcLinkVector &ret) const;
   void getActSrcLinks(SrcLinkVector &ret) const;
 
+  // builds an immutable compressed sparse row snapshot of the graph for
+  // the Alg overloads accepting CsrGraph, node and link indices in the
+  // snapshot match their positions in nodes() and linkData()
+  void freeze(CsrGraph &ret) const;
+
+  // returns a deep copy of the graph, the copy's nodes and links have the
+  // same IDs as the originals and no neighbor indices until they are needed
+  virtual Graph *clone() const
+  {
+    Graph *ret = new Graph(m_netFactory->newINetFactory());
+    copyTo(*ret);
+    return ret;
+  }
+
+  MemoryUsage memoryUsage() const;
+  // moves the nodes and links into freshly allocated memory in the ID
+  // order and frees the memory held by the factory, including objects
+  // dropped by ClearNodesByPredicate or ImposeDegreeCutoff; pointers to
+  // the nodes and links of the graph are invalidated
+  virtual void compact();
+
+  // store and restore the activation times of all nodes and links, the
+  // nodes and links must not be added or removed in between
+  void SaveActivation(ActivationState &ret) const;
+  void RestoreActivation(const ActivationState &state);
+
+  // should be called after m_dactTime of nodes or links is changed
+  // directly rather than through the methods of the graph, so that Deact
+  // and DeactLinks pick the elements activated that way
+  inline void invalidateActivation()
+  {
+    m_nodeAct.invalidate();
+    m_linkAct.invalidate();
+  }
+
+  // Deact and DeactLinks deactivate needDeact random active elements in
+  // O(needDeact) time and return the number of the elements remaining
+  // active; haveAct is ignored as the graph tracks the number of active
+  // elements itself; an element found deactivated by a direct write to
+  // m_dactTime is not picked, its index is rebuilt instead, and elements
+  // activated by direct writes are picked only after
+  // invalidateActivation() or ActAll
   size_t ActAll();
   size_t Deact(size_t needDeact, size_t haveAct, int dactTime);
 
@@ -136,9 +248,16 @@ public:
   virtual void WriteGdf(const char *gPath,
                         NodeWriter *nwriter = 0, LinkWriter *lwriter = 0);
 
+  // reads a list of links, one "name1 name2" pair per line, empty lines
+  // and lines starting with '#' are skipped
+  // if numericNames is true, the names must be non-negative integers;
+  // names below a limit proportional to the file size are mapped to nodes
+  // through an array and indexed by name only once per node, so that
+  // densely numbered nodes are read fast, larger ones are looked up by
+  // name
   void ReadAdjacency(const char *path, bool prune = false,
                      int n = -1, bool containsDuplicates = false,
-                     bool directed = false);
+                     bool directed = false, bool numericNames = false);
   void WriteAdjacency(const char *fileName, bool gccOnly, bool directed);
 
   double NodesForFraction(double f);
@@ -5,6 +5,7 @@
   See LICENSE file in the project root for full license information.
 */
 
+#include <cstddef>
 #include <vector>
 #include <list>
 #include "Graphs/libgraphs.h"
@@ -12,6 +13,8 @@
 #ifndef LINK_HEADER_FILE_INCLUDED
 #define LINK_HEADER_FILE_INCLUDED
 
+class Node;
+
 class LinkData
 {
   void init()
@@ -22,12 +25,22 @@ class LinkData
     m_btws = -1;
     m_dactTime = -1;
     m_isTemp = false;
+    m_id = -1;
+    m_src = m_dst = NULL;
   }
 
 public:
   mutable int m_tag;
   mutable double m_dtag;
 
+  // dense ID maintained by Graph, equals the link's index in
+  // Graph::linkData(), -1 for links not in a graph
+  int m_id;
+  // end nodes set when the link is added to a node for the first time,
+  // any of the two for undirected links
+  Node *m_src;
+  Node *m_dst;
+
   std::string m_name;
   bool m_directed;
   double m_btws;
@@ -21,8 +21,28 @@ public:
   virtual ~INetFactory() {}
   virtual Node *nextNode() = 0;
   virtual LinkData *nextLink() = 0;
+  // rewind to count nodes or links, throw an exception if count exceeds
+  // the number handed out
   virtual void resizeNodes(int count) = 0;
   virtual void resizeLinks(int count) = 0;
+  // preallocate memory for count nodes or links in total
+  virtual void reserveNodes(int count) = 0;
+  virtual void reserveLinks(int count) = 0;
+  // return a node or a link, which must not be referenced any more, to be
+  // handed out again by nextNode() or nextLink()
+  virtual void releaseNode(Node *n) = 0;
+  virtual void releaseLink(LinkData *ld) = 0;
+  // return a new node or link assigned from src, which must have been
+  // created by a factory of the same type; the copy refers to the same
+  // nodes and links as src does
+  virtual Node *copyNode(const Node *src) = 0;
+  virtual LinkData *copyLink(const LinkData *src) = 0;
+  // sizes of the node and link objects and the total number of bytes
+  // allocated for them
+  virtual size_t nodeSize() const = 0;
+  virtual size_t linkSize() const = 0;
+  virtual size_t nodesMemory() const = 0;
+  virtual size_t linksMemory() const = 0;
 };
 
 template<typename NType, typename LType>
@@ -30,44 +50,122 @@ template<typename NType, typename LType>
   {
     BlockMemMgr<NType> m_nodeMMgr;
     BlockMemMgr<LType> m_linkMMgr;
+    // released objects reused before the arenas are advanced
+    std::vector<NType *> m_freeNodes;
+    std::vector<LType *> m_freeLinks;
 
   public:
     NetFactory()
     {
     }
 
+    NetFactory(size_t nodeBlkSize, size_t linkBlkSize)
+      : m_nodeMMgr(nodeBlkSize), m_linkMMgr(linkBlkSize)
+    {
+    }
+
     virtual ~NetFactory()
     {
     }
 
     virtual INetFactory *newINetFactory()
     {
-      return new NetFactory<NType, LType>();
+      return new NetFactory<NType, LType>(m_nodeMMgr.blockSize(),
+                                          m_linkMMgr.blockSize());
     }
 
     virtual Node *nextNode()
     {
-      Node *ret = &m_nodeMMgr.next();
+      Node *ret;
+      if (m_freeNodes.size() > 0)
+      {
+        ret = m_freeNodes.back();
+        m_freeNodes.pop_back();
+      }
+      else
+        ret = &m_nodeMMgr.next();
       ret->reinit();
       return ret;
     }
 
     virtual LinkData *nextLink()
     {
-      LinkData *ret = &m_linkMMgr.next();
+      LinkData *ret;
+      if (m_freeLinks.size() > 0)
+      {
+        ret = m_freeLinks.back();
+        m_freeLinks.pop_back();
+      }
+      else
+        ret = &m_linkMMgr.next();
       ret->reinit();
       return ret;
     }
 
+    // rewinding an arena discards the released objects as well
     virtual void resizeNodes(int count)
     {
       m_nodeMMgr.resize(count);
+      m_freeNodes.clear();
     }
 
     virtual void resizeLinks(int count)
     {
       m_linkMMgr.resize(count);
+      m_freeLinks.clear();
+    }
+
+    virtual void releaseNode(Node *n)
+    {
+      m_freeNodes.push_back(static_cast<NType *>(n));
+    }
+
+    virtual void releaseLink(LinkData *ld)
+    {
+      m_freeLinks.push_back(static_cast<LType *>(ld));
+    }
+
+    virtual Node *copyNode(const Node *src)
+    {
+      NType *ret = static_cast<NType *>(nextNode());
+      *ret = *static_cast<const NType *>(src);
+      return ret;
     }
+
+    virtual LinkData *copyLink(const LinkData *src)
+    {
+      LType *ret = static_cast<LType *>(nextLink());
+      *ret = *static_cast<const LType *>(src);
+      return ret;
+    }
+
+    virtual void reserveNodes(int count)
+    {
+      m_nodeMMgr.reserve(count);
+    }
+
+    virtual void reserveLinks(int count)
+    {
+      m_linkMMgr.reserve(count);
+    }
+
+    virtual size_t nodeSize() const { return sizeof(NType); }
+    virtual size_t linkSize() const { return sizeof(LType); }
+
+    virtual size_t nodesMemory() const
+    {
+      return m_nodeMMgr.memoryUsage() +
+             m_freeNodes.capacity() * sizeof(NType *);
+    }
+
+    virtual size_t linksMemory() const
+    {
+      return m_linkMMgr.memoryUsage() +
+             m_freeLinks.capacity() * sizeof(LType *);
+    }
+
+    inline BlockMemMgr<NType> &nodeMMgr() { return m_nodeMMgr; }
+    inline BlockMemMgr<LType> &linkMMgr() { return m_linkMMgr; }
   };
 
 #endif // NETFACTORY_HEADER_FILE_INCLUDED
\ No newline at end of file
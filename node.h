@@ -8,9 +8,11 @@
 #include <map>
 #include <queue>
 #include <stack>
+#include <unordered_map>
 #include "Utils/dpoint.h"
 #include "Graphs/libgraphs.h"
 #include "Graphs/link.h"
+#include "Graphs/ptrmap.h"
 
 #ifndef NODE_HEADER_FILE_INCLUDED
 #define NODE_HEADER_FILE_INCLUDED
@@ -27,9 +29,38 @@ typedef std::map<int, PNodeVector *> IntPNodeVectorMap;
 typedef std::map<int, PNodeVector *>::iterator IntPNodeVectorMapIt;
 typedef std::map<int, PNodeVector *>::reverse_iterator IntPNodeVectorMapRIt;
 
-typedef std::map<std::string, Node *> StrPNodeMap;
-typedef std::map<std::string, Node *>::iterator StrPNodeMapIt;
-typedef std::map<std::string, Node *>::reverse_iterator StrPNodeMapRIt;
+typedef std::unordered_map<std::string, Node *> StrPNodeMap;
+typedef std::unordered_map<std::string, Node *>::iterator StrPNodeMapIt;
+
+typedef PtrHashMap<Node *, LinkData *> NbrIndex;
+
+// owning pointer to a neighbor index, copies of it are empty so that
+// copied nodes build their own indices when needed
+class NbrIndexPtr
+{
+  NbrIndex *m_ptr;
+
+public:
+  NbrIndexPtr() : m_ptr(NULL) {}
+  NbrIndexPtr(const NbrIndexPtr &) : m_ptr(NULL) {}
+  ~NbrIndexPtr() { delete m_ptr; }
+
+  NbrIndexPtr &operator=(const NbrIndexPtr &)
+  {
+    reset(NULL);
+    return *this;
+  }
+
+  void reset(NbrIndex *ptr)
+  {
+    if (ptr != m_ptr)
+      delete m_ptr;
+    m_ptr = ptr;
+  }
+
+  inline operator NbrIndex *() const { return m_ptr; }
+  inline NbrIndex *operator->() const { return m_ptr; }
+};
 
 
 class Node
@@ -37,20 +68,40 @@ class Node
   LinkVector m_links;
   LinkVector m_inLinks;
 
+  // neighbor indices are built lazily by findLink and findInLink for nodes
+  // with at least INDEX_MIN_LINKS links and are kept up to date afterwards
+  NbrIndexPtr m_linksIndex;
+  NbrIndexPtr m_inLinksIndex;
+
   void initLinks()
   {
     m_links.clear();
-    m_linksMap = NULL;
     m_inLinks.clear();
+    deleteIndices();
+  }
+
+  void deleteIndices()
+  {
+    m_linksIndex.reset(NULL);
+    m_inLinksIndex.reset(NULL);
+  }
+
+  static NbrIndex *buildIndex(const LinkVector &links)
+  {
+    NbrIndex *ret = new NbrIndex(links.size());
+    for (size_t i = 0; i < links.size(); i++)
+      ret->insert(links[i].n, links[i].d);
+    return ret;
   }
 
   void init()
   {
+    m_id = -1;
     m_name = "";
     m_compId = -1;
     m_timesInGC = 0;
     m_compSize = 0;
-    m_btws = m_clss = m_frns = -1;
+    m_btws = m_clss = m_frns = m_ecc = -1;
     m_annd = m_clCoef = 0;
     m_dactTime = -1;
     m_pathTol = 0;
@@ -61,23 +112,49 @@ class Node
 protected:
   inline void addLinkUnilateral(const Link &l)
   {
-    if (m_links.size() == 300)
-    {
-      m_linksMap = new std::map<Node *, LinkData *>();
-      for (size_t i = 0; i < m_links.size(); i++)
-        (*m_linksMap)[m_links[i].n] = m_links[i].d;
-    }
     m_links.push_back(l);
-    if (m_linksMap != NULL)
-      (*m_linksMap)[l.n] = l.d;
+    if (m_linksIndex != NULL)
+      m_linksIndex->insert(l.n, l.d);
   }
 
   inline void addInLinkUnilateral(const Link &il)
   {
     m_inLinks.push_back(il);
+    if (m_inLinksIndex != NULL)
+      m_inLinksIndex->insert(il.n, il.d);
+  }
+
+  // removes link d to or from n by moving the last entry in its place
+  static void removeLinkUnilateral(LinkVector &links, NbrIndex *index,
+                                   Node *n, LinkData *d)
+  {
+    size_t i = 0;
+    while (i < links.size() && links[i].d != d)
+      i++;
+    if (i == links.size())
+      return;
+    links[i] = links.back();
+    links.pop_back();
+
+    if (index != NULL)
+    {
+      // another (parallel) link to n takes over the index entry
+      index->erase(n);
+      for (size_t j = 0; j < links.size(); j++)
+        if (links[j].n == n)
+        {
+          index->insert(n, links[j].d);
+          break;
+        }
+    }
   }
 
 public:
+  enum { INDEX_MIN_LINKS = 32 };
+
+  // dense ID maintained by Graph, equals the node's index in Graph::nodes(),
+  // -1 for nodes not in a graph
+  int m_id;
   std::string m_name;
   mutable int m_tag;
   mutable double m_dtag;
@@ -98,10 +175,9 @@ public:
   double m_btws;
   double m_frns;
   double m_clss;
+  double m_ecc;
   double m_clCoef;
 
-  std::map<Node *, LinkData *> *m_linksMap;
-
   Node()
   {
     init();
@@ -109,29 +185,42 @@ public:
 
   virtual ~Node()
   {
-    delete m_linksMap;
+    deleteIndices();
   }
 
   virtual void reinit()
   {
-    delete m_linksMap;
+    deleteIndices();
     init();
   }
 
   virtual void reinitLinks()
   {
-    delete m_linksMap;
+    deleteIndices();
     initLinks();
   }
 
   void link(Node *n, LinkData *d)
   {
+    if (d->m_src == NULL)
+    {
+      d->m_src = this;
+      d->m_dst = n;
+    }
     Link l = { n, d };
     addLinkUnilateral(l);
     Link il = { this, d };
     n->addInLinkUnilateral(il);
   }
 
+  // removes link d to n from the links of this node and the in-links of n,
+  // the order of the remaining links is not preserved
+  void unlink(Node *n, LinkData *d)
+  {
+    removeLinkUnilateral(m_links, m_linksIndex, n, d);
+    removeLinkUnilateral(n->m_inLinks, n->m_inLinksIndex, this, d);
+  }
+
   void clearTempLinks()
   {
     LinkVector::iterator itx = m_links.begin();
@@ -154,8 +243,7 @@ public:
     }
     m_inLinks.erase(itx, it);
 
-    delete m_linksMap;
-    m_linksMap = 0;
+    deleteIndices();
   }
 
   void updateNumActLinks()
@@ -172,6 +260,22 @@ public:
   inline LinkVector &links() { return m_links; }
   inline LinkVector &inLinks() { return m_inLinks; }
 
+  // return the numbers of bytes allocated by the node for its link vectors
+  // and neighbor indices
+  inline size_t adjacencyMemory() const
+  {
+    return (m_links.capacity() + m_inLinks.capacity()) * sizeof(Link);
+  }
+  inline size_t indicesMemory() const
+  {
+    size_t ret = 0;
+    if (m_linksIndex != NULL)
+      ret += sizeof(NbrIndex) + m_linksIndex->memoryUsage();
+    if (m_inLinksIndex != NULL)
+      ret += sizeof(NbrIndex) + m_inLinksIndex->memoryUsage();
+    return ret;
+  }
+
   void getNeighbors(std::map<Node *, bool> &ret) const
   {
     for (size_t i = 0; i < m_links.size(); i++)
@@ -182,13 +286,12 @@ public:
 
   inline LinkData *findLink(Node *n2)
   {
-    if (m_linksMap != NULL)
+    if (m_linksIndex == NULL && m_links.size() >= INDEX_MIN_LINKS)
+      m_linksIndex.reset(buildIndex(m_links));
+    if (m_linksIndex != NULL)
     {
-      std::map<Node *, LinkData *>::iterator it = m_linksMap->find(n2);
-      if (it == m_linksMap->end())
-        return NULL;
-      else
-        return it->second;
+      LinkData **ret = m_linksIndex->find(n2);
+      return ret != NULL ? *ret : NULL;
     }
     for (size_t i = 0; i < m_links.size(); i++)
       if (m_links[i].n == n2)
@@ -198,6 +301,13 @@ public:
 
   inline LinkData *findInLink(Node *n1)
   {
+    if (m_inLinksIndex == NULL && m_inLinks.size() >= INDEX_MIN_LINKS)
+      m_inLinksIndex.reset(buildIndex(m_inLinks));
+    if (m_inLinksIndex != NULL)
+    {
+      LinkData **ret = m_inLinksIndex->find(n1);
+      return ret != NULL ? *ret : NULL;
+    }
     for (size_t i = 0; i < m_inLinks.size(); i++)
       if (m_inLinks[i].n == n1)
         return m_inLinks[i].d;
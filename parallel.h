@@ -0,0 +1,138 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <atomic>
+
+#ifndef PARALLEL_HEADER_FILE_INCLUDED
+#define PARALLEL_HEADER_FILE_INCLUDED
+
+/*
+  Work run by Parallel::Run on a group of threads
+*/
+class IParallelTask
+{
+public:
+  virtual ~IParallelTask() {}
+
+  // called once on each thread of the group with thread set to 0 to
+  // numThreads - 1
+  virtual void run(int thread, int numThreads) = 0;
+  // called when run throws an exception on any thread so that the other
+  // threads can stop instead of waiting for it
+  virtual void cancel() {}
+};
+
+/*
+  Reusable barrier for a fixed number of threads
+  A cancelled barrier releases the waiting threads and does not block
+  any more
+*/
+class Barrier
+{
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  const int m_count;
+  int m_waiting;
+  unsigned m_generation;
+  bool m_cancelled;
+
+public:
+  Barrier(int count)
+    : m_count(count), m_waiting(0), m_generation(0), m_cancelled(false)
+  {
+  }
+
+  // returns false if the barrier is cancelled
+  bool wait()
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_cancelled)
+      return false;
+    const unsigned gen = m_generation;
+    if (++m_waiting == m_count)
+    {
+      m_waiting = 0;
+      m_generation++;
+      m_cv.notify_all();
+      return true;
+    }
+    while (gen == m_generation && !m_cancelled)
+      m_cv.wait(lock);
+    return !m_cancelled || gen != m_generation;
+  }
+
+  void cancel()
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancelled = true;
+    m_cv.notify_all();
+  }
+};
+
+class Parallel
+{
+  static void runThread(IParallelTask *task, int thread, int numThreads,
+                        std::exception_ptr *error)
+  {
+    try
+    {
+      task->run(thread, numThreads);
+    }
+    catch (...)
+    {
+      *error = std::current_exception();
+      task->cancel();
+    }
+  }
+
+public:
+  // returns numThreads if it is positive or the number of hardware threads
+  static int NumThreads(int numThreads)
+  {
+    if (numThreads > 0)
+      return numThreads;
+    int ret = (int)std::thread::hardware_concurrency();
+    return ret > 0 ? ret : 1;
+  }
+
+  // runs task on numThreads threads including the calling one and waits
+  // for them to finish, rethrows the first exception thrown by the task
+  static void Run(IParallelTask &task, int numThreads)
+  {
+    std::vector<std::exception_ptr> errors(numThreads);
+    std::vector<std::thread> threads;
+    try
+    {
+      threads.reserve(numThreads - 1);
+      for (int i = 1; i < numThreads; i++)
+        threads.push_back(std::thread(runThread, &task, i, numThreads,
+                                      &errors[i]));
+    }
+    catch (...)
+    {
+      // the started threads may wait for the others at a barrier
+      task.cancel();
+      for (size_t i = 0; i < threads.size(); i++)
+        threads[i].join();
+      throw;
+    }
+    runThread(&task, 0, numThreads, &errors[0]);
+    for (size_t i = 0; i < threads.size(); i++)
+      threads[i].join();
+
+    for (int i = 0; i < numThreads; i++)
+      if (errors[i])
+        std::rethrow_exception(errors[i]);
+  }
+};
+
+#endif // PARALLEL_HEADER_FILE_INCLUDED
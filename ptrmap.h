@@ -0,0 +1,188 @@
+/*
+  Copyright (c) 2018-2019 Alexander A. Ganin. All rights reserved.
+  Twitter: @alxga. Website: alexganin.com.
+  Licensed under the MIT License.
+  See LICENSE file in the project root for full license information.
+*/
+
+#include <cstddef>
+#include <stdint.h>
+
+#ifndef PTRMAP_HEADER_FILE_INCLUDED
+#define PTRMAP_HEADER_FILE_INCLUDED
+
+/*
+  Open addressing (linear probing) hash map with pointer keys stored in
+  a single flat array, NULL keys are reserved to mark empty slots
+  The table is kept at most half full
+*/
+template<typename K, typename V>
+  class PtrHashMap
+  {
+    struct Slot
+    {
+      K key;
+      V value;
+    };
+
+    Slot *m_slots;
+    size_t m_mask;
+    size_t m_count;
+
+    static inline size_t hash(K key)
+    {
+      uint64_t h = (uint64_t)(uintptr_t)key;
+      h ^= h >> 33;
+      h *= 0xff51afd7ed558ccdULL;
+      h ^= h >> 33;
+      return (size_t)h;
+    }
+
+    void rehash(size_t capacity)
+    {
+      Slot *old = m_slots;
+      size_t oldCapacity = old != NULL ? m_mask + 1 : 0;
+
+      m_slots = new Slot[capacity];
+      m_mask = capacity - 1;
+      for (size_t i = 0; i < capacity; i++)
+        m_slots[i].key = NULL;
+
+      for (size_t i = 0; i < oldCapacity; i++)
+        if (old[i].key != NULL)
+        {
+          size_t ix = hash(old[i].key) & m_mask;
+          while (m_slots[ix].key != NULL)
+            ix = (ix + 1) & m_mask;
+          m_slots[ix] = old[i];
+        }
+      delete [] old;
+    }
+
+  public:
+    PtrHashMap(size_t expected = 0) : m_slots(NULL), m_mask(0), m_count(0)
+    {
+      reserve(expected);
+    }
+
+    // copies own separate tables
+    PtrHashMap(const PtrHashMap &v) : m_slots(NULL), m_mask(0), m_count(0)
+    {
+      *this = v;
+    }
+
+    ~PtrHashMap()
+    {
+      delete [] m_slots;
+    }
+
+    PtrHashMap &operator= (const PtrHashMap &v)
+    {
+      if (this == &v)
+        return *this;
+      Slot *slots = NULL;
+      if (v.m_slots != NULL)
+      {
+        slots = new Slot[v.m_mask + 1];
+        for (size_t i = 0; i <= v.m_mask; i++)
+          slots[i] = v.m_slots[i];
+      }
+      delete [] m_slots;
+      m_slots = slots;
+      m_mask = v.m_mask;
+      m_count = v.m_count;
+      return *this;
+    }
+
+    // makes room for count keys without further rehashing
+    void reserve(size_t count)
+    {
+      size_t capacity = 16;
+      while (capacity < 2 * count)
+        capacity *= 2;
+      if (m_slots == NULL || capacity > m_mask + 1)
+        rehash(capacity);
+    }
+
+    void clear()
+    {
+      for (size_t i = 0; m_slots != NULL && i <= m_mask; i++)
+        m_slots[i].key = NULL;
+      m_count = 0;
+    }
+
+    inline size_t size() const { return m_count; }
+    // returns the number of bytes allocated by the map
+    inline size_t memoryUsage() const
+    {
+      return m_slots != NULL ? (m_mask + 1) * sizeof(Slot) : 0;
+    }
+
+    // returns a pointer to the value stored for key or NULL
+    inline V *find(K key) const
+    {
+      size_t ix = hash(key) & m_mask;
+      while (m_slots[ix].key != NULL)
+      {
+        if (m_slots[ix].key == key)
+          return &m_slots[ix].value;
+        ix = (ix + 1) & m_mask;
+      }
+      return NULL;
+    }
+
+    // stores value for key unless key is present already,
+    // returns a pointer to the value stored for key after the call
+    V *insert(K key, const V &value)
+    {
+      if (2 * (m_count + 1) > m_mask + 1)
+        rehash(2 * (m_mask + 1));
+
+      size_t ix = hash(key) & m_mask;
+      while (m_slots[ix].key != NULL)
+      {
+        if (m_slots[ix].key == key)
+          return &m_slots[ix].value;
+        ix = (ix + 1) & m_mask;
+      }
+      m_slots[ix].key = key;
+      m_slots[ix].value = value;
+      m_count++;
+      return &m_slots[ix].value;
+    }
+
+    // removes key, returns false if it is not present
+    // entries following the removed one in its probe run are shifted back
+    // so that no tombstones are needed
+    bool erase(K key)
+    {
+      if (m_slots == NULL)
+        return false;
+      size_t ix = hash(key) & m_mask;
+      while (m_slots[ix].key != key)
+      {
+        if (m_slots[ix].key == NULL)
+          return false;
+        ix = (ix + 1) & m_mask;
+      }
+
+      size_t hole = ix;
+      for (ix = (ix + 1) & m_mask; m_slots[ix].key != NULL;
+           ix = (ix + 1) & m_mask)
+      {
+        // an entry may fill the hole unless its home slot lies cyclically
+        // in (hole, ix]
+        size_t home = hash(m_slots[ix].key) & m_mask;
+        if (((ix - home) & m_mask) >= ((ix - hole) & m_mask))
+        {
+          m_slots[hole] = m_slots[ix];
+          hole = ix;
+        }
+      }
+      m_slots[hole].key = NULL;
+      m_count--;
+      return true;
+    }
+  };
+
+#endif // PTRMAP_HEADER_FILE_INCLUDED
@@ -14,6 +14,8 @@
 
 #include <algorithm>
 #include <numeric>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <string>
 #include <time.h>